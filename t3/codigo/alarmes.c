@@ -0,0 +1,89 @@
+// alarmes.c
+// conjunto de alarmes ordenados por data
+// simulador de computador
+// so25b
+
+#include "alarmes.h"
+#include <stdlib.h>
+#include <assert.h>
+
+typedef struct {
+  int data;
+  int valor;
+} alarme_t;
+
+struct alarmes_t {
+  // heap binário em um vetor: os filhos da posição i estão nas posições
+  //   2i+1 e 2i+2, e nenhum tem data menor que a dele
+  alarme_t *heap;
+  int n_alarmes;
+  int cap;
+};
+
+alarmes_t *alarmes_cria(void)
+{
+  alarmes_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->n_alarmes = 0;
+  self->cap = 8;
+  self->heap = malloc(self->cap * sizeof(alarme_t));
+  assert(self->heap != NULL);
+  return self;
+}
+
+void alarmes_destroi(alarmes_t *self)
+{
+  free(self->heap);
+  free(self);
+}
+
+bool alarmes_vazio(alarmes_t *self)
+{
+  return self->n_alarmes == 0;
+}
+
+void alarmes_insere(alarmes_t *self, int data, int valor)
+{
+  if (self->n_alarmes == self->cap) {
+    self->cap *= 2;
+    self->heap = realloc(self->heap, self->cap * sizeof(alarme_t));
+    assert(self->heap != NULL);
+  }
+  // sobe a partir da última posição até achar o lugar do novo alarme
+  int i = self->n_alarmes++;
+  while (i > 0) {
+    int pai = (i - 1) / 2;
+    if (self->heap[pai].data <= data) break;
+    self->heap[i] = self->heap[pai];
+    i = pai;
+  }
+  self->heap[i] = (alarme_t){ data, valor };
+}
+
+int alarmes_proxima_data(alarmes_t *self)
+{
+  assert(self->n_alarmes > 0);
+  return self->heap[0].data;
+}
+
+int alarmes_retira(alarmes_t *self)
+{
+  assert(self->n_alarmes > 0);
+  int valor = self->heap[0].valor;
+  // o último alarme desce a partir da raiz até achar o seu lugar
+  alarme_t ultimo = self->heap[--self->n_alarmes];
+  int i = 0;
+  for (;;) {
+    int filho = 2 * i + 1;
+    if (filho >= self->n_alarmes) break;
+    if (filho + 1 < self->n_alarmes
+        && self->heap[filho + 1].data < self->heap[filho].data) {
+      filho++;
+    }
+    if (ultimo.data <= self->heap[filho].data) break;
+    self->heap[i] = self->heap[filho];
+    i = filho;
+  }
+  self->heap[i] = ultimo;
+  return valor;
+}
@@ -0,0 +1,42 @@
+// alarmes.h
+// conjunto de alarmes ordenados por data
+// simulador de computador
+// so25b
+
+#ifndef ALARMES_H
+#define ALARMES_H
+
+// mantém um conjunto de alarmes, cada um com uma data (em tics do relógio) e
+//   um valor (o pid de um processo a acordar, por exemplo)
+// os alarmes ficam em um heap ordenado pela data: consultar o próximo alarme
+//   não depende do número de alarmes, e inserir ou retirar um alarme depende
+//   do logaritmo desse número
+// alarmes com a mesma data não têm ordem definida entre eles
+
+#include <stdbool.h>
+
+// tipo opaco que representa o conjunto de alarmes
+typedef struct alarmes_t alarmes_t;
+
+// cria um conjunto de alarmes vazio
+// mata o programa em caso de erro (malloc)
+alarmes_t *alarmes_cria(void);
+
+// destrói um conjunto de alarmes
+void alarmes_destroi(alarmes_t *self);
+
+// retorna true se não tiver nenhum alarme
+bool alarmes_vazio(alarmes_t *self);
+
+// insere um alarme com o valor 'valor' para a data 'data'
+void alarmes_insere(alarmes_t *self, int data, int valor);
+
+// retorna a data do próximo alarme (o de menor data)
+// não deve ser chamada com o conjunto vazio
+int alarmes_proxima_data(alarmes_t *self);
+
+// retira o próximo alarme, e retorna o seu valor
+// não deve ser chamada com o conjunto vazio
+int alarmes_retira(alarmes_t *self);
+
+#endif // ALARMES_H
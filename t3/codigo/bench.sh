@@ -0,0 +1,74 @@
+#!/bin/bash
+# executa o simulador sem tela para todas as combinações de escalonador,
+#   quantum, tamanho da memória principal, tamanho de página e programa
+#   inicial, e junta as estatísticas de cada execução (main -m) em bench.csv
+#   e bench.json
+# deve ser executado no diretório do simulador, depois do make (ver o alvo
+#   bench no Makefile)
+# os valores de cada parâmetro podem ser trocados por variáveis de ambiente,
+#   por exemplo: MEMS="160 200" PROGRAMAS=init ./bench.sh
+# com pouca memória, a execução pode não terminar (os processos tiram as
+#   páginas uns dos outros sem parar); ela é interrompida depois de TEMPO_MAX
+#   segundos, e fica sem estatísticas
+# ex2, ex4, ex5 e ex6 acessam os dispositivos diretamente, sem chamadas de
+#   sistema, e não executam como processos; por isso não estão nos programas
+# carga_cpu, carga_es e carga_mem são cargas sintéticas, montadas com as
+#   macros de cargas.asm; o tamanho delas é definido no início de cada uma
+
+ESCALONADORES=${ESCALONADORES:-"simples round_robin prioridade mlfq"}
+QUANTA=${QUANTA:-"2 10"}
+MEMS=${MEMS:-"240 10000"}
+PAGINAS=${PAGINAS:-"10 20"}
+PROGRAMAS=${PROGRAMAS:-"init p1 p2 p3 ex3 carga_cpu carga_es carga_mem"}
+TEMPO_MAX=${TEMPO_MAX:-120}  # em segundos, para cada execução
+CSV=${CSV:-bench.csv}
+JSON=${JSON:-bench.json}
+
+# as estatísticas escritas por main -m, na ordem das colunas
+METRICAS="tics cpu_parada tlb_acertos tlb_falhas processos trocas preempcoes
+          faltas substituicoes escritas_mem2 transferencias disco_ocupado
+          disco_sobreposto"
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+echo escalonador quantum mem_tam tam_pagina programa rc $METRICAS \
+  | tr ' ' ',' > "$CSV"
+echo "[" > "$JSON"
+sep=""
+for esc in $ESCALONADORES; do
+for q in $QUANTA; do
+for mem in $MEMS; do
+for pag in $PAGINAS; do
+for prog in $PROGRAMAS; do
+  cat > "$tmp/cfg" <<FIM
+escalonador $esc
+quantum $q
+mem_tam $mem
+tam_pagina $pag
+programa_inicial $prog.maq
+FIM
+  rm -f "$tmp/metricas"
+  timeout "$TEMPO_MAX" ./main -s -c "$tmp/cfg" -m "$tmp/metricas" > /dev/null
+  rc=$?
+  echo "$esc quantum $q, memória $mem, página $pag, $prog: rc $rc" >&2
+
+  # uma execução que não terminou não tem estatísticas (vazio no CSV, null
+  #   no JSON)
+  linha="$esc,$q,$mem,$pag,$prog,$rc"
+  obj="\"escalonador\": \"$esc\", \"quantum\": $q, \"mem_tam\": $mem"
+  obj="$obj, \"tam_pagina\": $pag, \"programa\": \"$prog\", \"rc\": $rc"
+  for nome in $METRICAS; do
+    valor=$(awk -v nome=$nome '$1 == nome { print $2 }' "$tmp/metricas" 2>/dev/null)
+    linha="$linha,$valor"
+    obj="$obj, \"$nome\": ${valor:-null}"
+  done
+  echo "$linha" >> "$CSV"
+  printf '%s  {%s}' "$sep" "$obj" >> "$JSON"
+  sep=$',\n'
+done
+done
+done
+done
+done
+printf '\n]\n' >> "$JSON"
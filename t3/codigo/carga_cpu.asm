@@ -0,0 +1,17 @@
+; carga_cpu.asm
+; carga sintética com bastante CPU e pouca E/S (ver cargas.asm)
+
+N        define 20000  ; repetições do cálculo
+
+         desv main
+         inclui sistema.asm
+         inclui cargas.asm
+prog     string 'carga_cpu '
+
+main     anuncia prog,N
+         calcula N
+         calcula N
+         conta N,5000
+         termina
+
+         inclui rotinas.asm
@@ -0,0 +1,15 @@
+; carga_es.asm
+; carga sintética com pouca CPU e bastante E/S (ver cargas.asm)
+
+N        define 100  ; números impressos
+
+         desv main
+         inclui sistema.asm
+         inclui cargas.asm
+prog     string 'carga_es '
+
+main     anuncia prog,N
+         conta N,1
+         termina
+
+         inclui rotinas.asm
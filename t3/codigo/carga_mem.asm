@@ -0,0 +1,17 @@
+; carga_mem.asm
+; carga sintética com um vetor maior que a memória principal (ver cargas.asm)
+
+TAM      define 400  ; posições do vetor
+VEZES    define 5    ; passadas pelo vetor
+
+         desv main
+         inclui sistema.asm
+         inclui cargas.asm
+prog     string 'carga_mem '
+
+main     anuncia prog,TAM
+         percorre TAM,VEZES
+         conta VEZES,1
+         termina
+
+         inclui rotinas.asm
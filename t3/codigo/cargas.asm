@@ -0,0 +1,84 @@
+; cargas.asm
+; macros para montar programas de carga sintética, para o bench.sh, com
+; 'inclui cargas.asm'; cada uso de uma macro gera o código no lugar, com
+; labels próprios (%%nome), e pode ser repetido à vontade
+; usa as chamadas de sistema de sistema.asm e as rotinas de rotinas.asm
+
+; soma 1 a um acumulador 'n' vezes, só com instruções que não acessam a
+; memória fora do laço: carga de CPU
+calcula  macro n
+         cargi 0
+         trax
+%%laco   incx
+         cpxa
+         mult %%dois
+         div %%dois
+         sub %%n
+         desvnz %%laco
+         desv %%fim
+%%dois   valor 2
+%%n      valor %n
+%%fim
+         fimmacro
+
+; conta de 1 até 'n', imprimindo o valor a cada 'cada': carga de E/S quando
+; 'cada' é pequeno
+conta    macro n,cada
+         cargi 0
+         trax
+%%laco   incx
+         cpxa
+         resto %%cada
+         desvnz %%pula
+         cpxa
+         chama impnum
+%%pula   cpxa
+         sub %%n
+         desvnz %%laco
+         desv %%fim
+%%cada   valor %cada
+%%n      valor %n
+%%fim
+         fimmacro
+
+; escreve em todas as 'tam' posições de um vetor, 'vezes' vezes: carga de
+; memória, com uma falta de página por página do vetor a cada passada quando
+; o vetor não cabe na memória principal
+percorre macro tam,vezes
+         cargi %vezes
+         armm %%cont
+%%volta  cargi 0
+         trax
+%%laco   cpxa
+         armx %%vet
+         incx
+         cpxa
+         sub %%tam
+         desvnz %%laco
+         cargm %%cont
+         sub %%um
+         armm %%cont
+         desvnz %%volta
+         desv %%fim
+%%um     valor 1
+%%tam    valor %tam
+%%cont   espaco 1
+%%vet    espaco %tam
+%%fim
+         fimmacro
+
+; imprime a string 'str' (um label) e o número 'n'
+anuncia  macro str,n
+         cargi %str
+         chama impstr
+         cargi %n
+         chama impnum
+         fimmacro
+
+; termina o processo
+termina  macro
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+         fimmacro
@@ -44,6 +44,9 @@
 // números de comandos para o controlador que podem ser guardados na console
 #define N_CMD_EXT 10
 
+// tamanho máximo do nome dos arquivos dos terminais, na execução sem tela
+#define TAM_NOME_ARQ 30
+
 
 // ---------------------------------------------------------------------
 // DECLARAÇÃO {{{1
@@ -58,6 +61,11 @@ struct console_t {
   char txt_entrada[N_COL+1];
   char fila_de_comandos_externos[N_CMD_EXT];
   FILE *arquivo_de_log;
+  // false se a console executa sem tela (em lote)
+  bool com_tela;
+  // arquivos de entrada e saída dos terminais, quando sem tela
+  FILE *arq_entrada[N_TERM];
+  FILE *arq_saida[N_TERM];
 };
 
 
@@ -66,14 +74,17 @@ struct console_t {
 // ---------------------------------------------------------------------
 
 static console_t *console_global; // gambiarra para simplificar o uso de prints na console
-console_t *console_cria(void)
+static console_t *console_cria_comum(bool com_tela)
 {
   console_t *self = malloc(sizeof(*self));
   assert(self != NULL);
   console_global = self;
 
+  self->com_tela = com_tela;
   for (int t = 0; t < N_TERM; t++) {
     self->term[t] = terminal_cria(N_COL);
+    self->arq_entrada[t] = NULL;
+    self->arq_saida[t] = NULL;
     if ((t % 2) == 0) {
       self->cor_txt[t] = COR_TXT_PAR;
       self->cor_cursor[t] = COR_CURSOR_PAR;
@@ -89,26 +100,57 @@ console_t *console_cria(void)
   self->fila_de_comandos_externos[0] = '\0';
   self->arquivo_de_log = fopen("log_da_console", "w");
 
+  return self;
+}
+
+console_t *console_cria(void)
+{
+  console_t *self = console_cria_comum(true);
+
   tela_init();
 
   return self;
 }
 
+console_t *console_cria_sem_tela(void)
+{
+  console_t *self = console_cria_comum(false);
+
+  // abre os arquivos de cada terminal; a falta do arquivo de entrada não é
+  //   erro, o terminal simplesmente não terá nada digitado
+  for (int t = 0; t < N_TERM; t++) {
+    char nome[TAM_NOME_ARQ];
+    sprintf(nome, "entrada_term_%c", 'a' + t);
+    self->arq_entrada[t] = fopen(nome, "r");
+    sprintf(nome, "saida_term_%c", 'a' + t);
+    self->arq_saida[t] = fopen(nome, "w");
+    terminal_define_arquivo_saida(self->term[t], self->arq_saida[t]);
+  }
+
+  return self;
+}
+
 static void console_desenha(console_t *self);
 
 void console_destroi(console_t *self)
 {
-  console_desenha(self);
+  if (self->com_tela) {
+    console_desenha(self);
+  }
   if (self->arquivo_de_log != NULL) fclose(self->arquivo_de_log);
-  tela_puts(COR_OCUPADO, "  digite ENTER para sair  ");
-  tela_atualiza();
-  while (tela_tecla() != '\n') {
-    ;
+  if (self->com_tela) {
+    tela_puts(COR_OCUPADO, "  digite ENTER para sair  ");
+    tela_atualiza();
+    while (tela_tecla() != '\n') {
+      ;
+    }
+    tela_fim();
   }
-  tela_fim();
 
   for (int t = 0; t < N_TERM; t++) {
     terminal_destroi(self->term[t]);
+    if (self->arq_entrada[t] != NULL) fclose(self->arq_entrada[t]);
+    if (self->arq_saida[t] != NULL) fclose(self->arq_saida[t]);
   }
   free(self);
   return;
@@ -149,6 +191,26 @@ static void insere_string_no_terminal(console_t *self, char id_terminal, char *s
   terminal_insere_char(terminal, ' ');
 }
 
+// na execução sem tela, faz o papel do operador: para cada terminal com a
+//   entrada vazia, entra a próxima linha do arquivo de entrada do terminal
+static void alimenta_terminais(console_t *self)
+{
+  for (int t = 0; t < N_TERM; t++) {
+    FILE *arq = self->arq_entrada[t];
+    if (arq == NULL) continue;
+    if (terminal_txt_entrada(self->term[t])[0] != '\0') continue;
+    char linha[N_COL+1];
+    if (fgets(linha, sizeof(linha), arq) == NULL) {
+      // acabou o arquivo, não tem mais o que digitar nesse terminal
+      fclose(arq);
+      self->arq_entrada[t] = NULL;
+      continue;
+    }
+    linha[strcspn(linha, "\r\n")] = '\0';
+    insere_string_no_terminal(self, 'a' + t, linha);
+  }
+}
+
 static void limpa_saida_do_terminal(console_t *self, char id_terminal)
 {
   terminal_t *terminal = console_terminal(self, id_terminal);
@@ -194,8 +256,15 @@ static void insere_strings_na_console(console_t *self, char *s)
 
 void console_print_status(console_t *self, char *txt)
 {
-  // imprime alinhado a esquerda ("-"), max N_COL chars ("*")
-  sprintf(self->txt_status, "%-*s", N_COL, txt);
+  // imprime alinhado a esquerda ("-"), N_COL chars ("*"), cortando o excesso
+  sprintf(self->txt_status, "%-*.*s", N_COL, N_COL, txt);
+}
+
+console_nivel_t console_nivel_log = LOG_INFO;
+
+void console_define_nivel_log(console_nivel_t nivel)
+{
+  console_nivel_log = nivel;
 }
 
 int console_printf(char *formato, ...)
@@ -296,6 +365,8 @@ static void verifica_entrada(console_t *self)
 
 char console_comando_externo(console_t *self)
 {
+  // sem tela, não tem operador para digitar comandos
+  if (!self->com_tela) return '\0';
   verifica_entrada(self);
   return remove_comando_externo(self);
 }
@@ -371,9 +442,38 @@ static void console_desenha(console_t *self)
 
 void console_tictac(console_t *self)
 {
+  if (!self->com_tela) {
+    alimenta_terminais(self);
+    atualiza_terminais(self);
+    return;
+  }
   verifica_entrada(self);
   atualiza_terminais(self);
   console_desenha(self);
 }
 
+void console_avanca(console_t *self, int n)
+{
+  if (n <= 0) return;
+  if (self->com_tela) {
+    for (int i = 0; i < n; i++) console_tictac(self);
+    return;
+  }
+  // depois do primeiro tic, as entradas só ficam vazias se forem lidas
+  alimenta_terminais(self);
+  for (int t = 0; t < N_TERM; t++) {
+    terminal_avanca(self->term[t], n);
+  }
+}
+
+bool console_entrada_pendente(console_t *self)
+{
+  if (self->com_tela) return false;
+  for (int t = 0; t < N_TERM; t++) {
+    if (self->arq_entrada[t] == NULL) continue;
+    if (terminal_txt_entrada(self->term[t])[0] == '\0') return true;
+  }
+  return false;
+}
+
 // vim: foldmethod=marker
@@ -14,12 +14,52 @@ typedef struct console_t console_t;
 // cria e inicializa a console
 console_t *console_cria(void);
 
+// cria e inicializa a console sem tela (para execução em lote)
+// não usa o terminal físico: a entrada de cada terminal ('A', 'B', etc) é
+//   lida do arquivo "entrada_term_a" (etc), uma linha por vez, sempre que
+//   a entrada do terminal estiver vazia; tudo que for impresso em um
+//   terminal é copiado para o arquivo "saida_term_a" (etc)
+// não aceita comandos do operador
+console_t *console_cria_sem_tela(void);
+
 // destrói a console
 void console_destroi(console_t *self);
 
 // imprime na área geral do console
 int console_printf(char *fmt, ...);
 
+// níveis de detalhe das mensagens impressas com console_log
+typedef enum {
+  LOG_ERRO,    // erros
+  LOG_INFO,    // eventos pouco frequentes (carga de programa, criação de processo)
+  LOG_DEPURA,  // eventos frequentes (cada interrupção, cada escalonamento)
+  LOG_TRACO,   // eventos a cada instrução (cada tradução de endereço)
+} console_nivel_t;
+
+// nível máximo das mensagens que são compiladas; as chamadas a console_log
+//   com nível maior que esse não geram código
+// pode ser alterado na compilação, por exemplo com
+//   make CPPFLAGS=-DLOG_NIVEL_MAX=LOG_INFO
+#ifndef LOG_NIVEL_MAX
+#define LOG_NIVEL_MAX LOG_TRACO
+#endif
+
+// nível máximo das mensagens que são impressas (alterável durante a execução)
+// as mensagens de nível maior não são nem formatadas
+extern console_nivel_t console_nivel_log;
+
+// define o nível máximo das mensagens impressas por console_log
+void console_define_nivel_log(console_nivel_t nivel);
+
+// imprime na área geral do console, como console_printf, se o nível da
+//   mensagem estiver habilitado (na compilação e na execução)
+#define console_log(nivel, ...)                                        \
+  do {                                                                 \
+    if ((nivel) <= LOG_NIVEL_MAX && (nivel) <= console_nivel_log) {    \
+      console_printf(__VA_ARGS__);                                     \
+    }                                                                  \
+  } while (0)
+
 // imprime na linha de status
 void console_print_status(console_t *self, char *txt);
 
@@ -40,4 +80,13 @@ terminal_t *console_terminal(console_t *self, char id_terminal);
 // esta função deve ser chamada periodicamente para que tela funcione
 void console_tictac(console_t *self);
 
+// na execução sem tela, tem o mesmo efeito de 'n' chamadas a console_tictac
+//   se nenhum terminal for alterado por outros nesse tempo
+// com tela, chama console_tictac 'n' vezes
+void console_avanca(console_t *self, int n);
+
+// retorna true se, na execução sem tela, a próxima chamada a console_tictac
+//   vai entrar a próxima linha do arquivo de entrada em algum terminal
+bool console_entrada_pendente(console_t *self);
+
 #endif // CONSOLE_H
@@ -10,19 +10,43 @@
 #include <stdio.h>
 #include <assert.h>
 
+// número máximo de tics executados em um lote na execução sem tela (ver
+//   controle_executa_lote); com 1, a execução é igual à com tela, um tic por
+//   vez (usado por verifica_nucleo.sh, como referência)
+#ifndef CONTROLE_LOTE_MAX
+#define CONTROLE_LOTE_MAX 1000
+#endif
+
 struct controle_t {
   cpu_t *cpu;
   relogio_t *relogio;
+  disco_t *disco;
   console_t *console;
+  // os terminais da console, que podem pedir interrupção
+  int n_terminais;
+  terminal_t **terminais;
   enum { executando, passo, parado, fim } estado;
+  // estatísticas
+  long t_parada;
+  long t_parada_com_disco;
+  // tics do lote em execução que já passaram nos dispositivos
+  int tics_sincronizados;
 };
 
 // funções auxiliares
+static void controle_executa_1(controle_t *self);
+static void controle_executa_lote(controle_t *self);
+static void controle_sincroniza(void *arg, int n_tics);
+static void controle_interrompe(controle_t *self);
+static bool controle_terminal_pede(controle_t *self,
+                                   bool pede(terminal_t *));
+static bool controle_maquina_parada(controle_t *self);
 static void controle_processa_comandos_da_console(controle_t *self);
 static void controle_atualiza_estado_na_console(controle_t *self);
 
 
-controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio)
+controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio,
+                          disco_t *disco)
 {
   controle_t *self = malloc(sizeof(*self));
   assert(self != NULL);
@@ -30,13 +54,28 @@ controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio)
   self->cpu = cpu;
   self->console = console;
   self->relogio = relogio;
+  self->disco = disco;
+  self->n_terminais = 0;
+  while (console_terminal(console, 'a' + self->n_terminais) != NULL) {
+    self->n_terminais++;
+  }
+  self->terminais = malloc(self->n_terminais * sizeof(terminal_t *));
+  assert(self->n_terminais == 0 || self->terminais != NULL);
+  for (int t = 0; t < self->n_terminais; t++) {
+    self->terminais[t] = console_terminal(console, 'a' + t);
+  }
   self->estado = parado;
+  self->t_parada = 0;
+  self->t_parada_com_disco = 0;
+  self->tics_sincronizados = 0;
+  cpu_define_sincroniza(cpu, controle_sincroniza, self);
 
   return self;
 }
 
 void controle_destroi(controle_t *self)
 {
+  free(self->terminais);
   free(self);
 }
 
@@ -45,18 +84,9 @@ void controle_laco(controle_t *self)
   // executa uma instrução por vez até a console dizer que chega
   do {
     if (self->estado == passo || self->estado == executando) {
-      cpu_executa_1(self->cpu);
-      relogio_tictac(self->relogio);
+      controle_executa_1(self);
 
       if (self->estado == passo) self->estado = parado;
-
-      // enquanto não tem controlador de interrupção, fala direto com o relógio
-      // o dispositivo 3 do relógio contém 1 se o timer expirou
-      int tem_int;
-      relogio_leitura(self->relogio, 3, &tem_int);
-      if (tem_int != 0) {
-        cpu_interrompe(self->cpu, IRQ_RELOGIO);
-      }
     }
     console_tictac(self->console);
 
@@ -66,8 +96,159 @@ void controle_laco(controle_t *self)
 
   console_printf("Fim da execução.");
 }
+
+void controle_laco_sem_tela(controle_t *self)
+{
+  // não tem operador, executa direto até a máquina parar de vez
+  self->estado = executando;
+  do {
+    controle_executa_lote(self);
+  } while (!controle_maquina_parada(self));
+  self->estado = fim;
+
+  console_printf("Fim da execução.");
+}
+
+// executa uma instrução, passa o tempo e atende as interrupções pendentes
+static void controle_executa_1(controle_t *self)
+{
+  if (cpu_parada(self->cpu)) {
+    self->t_parada++;
+    if (disco_ocupado(self->disco)) self->t_parada_com_disco++;
+  }
+  cpu_executa_1(self->cpu);
+  relogio_tictac(self->relogio);
+  disco_tictac(self->disco);
+  controle_interrompe(self);
+}
+
+// retorna quantos tics podem ser executados de uma vez a partir de agora sem
+//   que nenhum dispositivo mude o pedido de interrupção no meio: 1 se algum
+//   pedido pendente pode ser aceito pela CPU ou se a console vai alterar um
+//   terminal no próximo tic, senão o tempo até o próximo evento do relógio,
+//   do disco ou da tela de um terminal
+// as alterações feitas pela CPU nos dispositivos e a volta a aceitar
+//   interrupções terminam o lote (ver cpu_executa); enquanto a CPU não aceita
+//   interrupções, os pedidos pendentes não mudam nada
+static int controle_tics_sem_eventos(controle_t *self)
+{
+  int tem_int, t_ate_int;
+  relogio_leitura(self->relogio, 3, &tem_int);
+  relogio_leitura(self->relogio, 2, &t_ate_int);
+  bool tem_pedido = tem_int != 0 || disco_interrupcao(self->disco)
+      || controle_terminal_pede(self, terminal_interrupcao_teclado)
+      || controle_terminal_pede(self, terminal_interrupcao_tela);
+  if ((tem_pedido && cpu_aceita_interrupcao(self->cpu))
+      || console_entrada_pendente(self->console)) {
+    return 1;
+  }
+  int n = CONTROLE_LOTE_MAX;
+  if (t_ate_int != 0 && t_ate_int < n) n = t_ate_int;
+  int t_disco = disco_tempo_ate_conclusao(self->disco);
+  if (t_disco != 0 && t_disco < n) n = t_disco;
+  for (int t = 0; t < self->n_terminais; t++) {
+    // só a tela com interrupção habilitada muda o pedido sozinha
+    if (!terminal_vai_interromper(self->terminais[t])) continue;
+    int t_tela = terminal_tempo_ate_imprimir(self->terminais[t]);
+    if (t_tela != 0 && t_tela < n) n = t_tela;
+  }
+  return n;
+}
+
+// faz passar 'n_tics' nos dispositivos e na console
+static void controle_passa_tempo(controle_t *self, int n_tics)
+{
+  relogio_avanca(self->relogio, n_tics);
+  disco_avanca(self->disco, n_tics);
+  console_avanca(self->console, n_tics);
+}
+
+// chamada pela CPU no meio de um lote, antes de acessar os dispositivos
+static void controle_sincroniza(void *arg, int n_tics)
+{
+  controle_t *self = arg;
+  controle_passa_tempo(self, n_tics);
+  self->tics_sincronizados += n_tics;
+}
+
+// executa um lote de instruções (ou de tics com a CPU parada) sem eventos
+//   nos dispositivos, passa o tempo e atende as interrupções pendentes
+// tem o mesmo efeito de chamar controle_executa_1 e console_tictac uma vez
+//   para cada tic do lote: só no último tic pode haver interrupção, e ela é
+//   pedida antes de a console passar esse tic, como em controle_laco
+static void controle_executa_lote(controle_t *self)
+{
+  int n = controle_tics_sem_eventos(self);
+  if (cpu_parada(self->cpu)) {
+    self->t_parada += n;
+    if (disco_ocupado(self->disco)) self->t_parada_com_disco += n;
+  } else {
+    // a CPU pode terminar o lote antes, se parar ou acessar um dispositivo
+    self->tics_sincronizados = 0;
+    n = cpu_executa(self->cpu, n) - self->tics_sincronizados;
+  }
+  controle_passa_tempo(self, n - 1);
+  relogio_tictac(self->relogio);
+  disco_tictac(self->disco);
+  controle_interrompe(self);
+  console_tictac(self->console);
+}
+
+// pede à CPU as interrupções pendentes nos dispositivos
+static void controle_interrompe(controle_t *self)
+{
+  // enquanto não tem controlador de interrupção, fala direto com o relógio
+  // o dispositivo 3 do relógio contém 1 se o timer expirou
+  int tem_int;
+  relogio_leitura(self->relogio, 3, &tem_int);
+  if (tem_int != 0) {
+    cpu_interrompe(self->cpu, IRQ_RELOGIO);
+  }
+  // se a interrupção do relógio foi aceita, a do disco fica para depois
+  if (disco_interrupcao(self->disco)) {
+    cpu_interrompe(self->cpu, IRQ_DISCO);
+  }
+  // os terminais só pedem as interrupções que o SO habilitou
+  if (controle_terminal_pede(self, terminal_interrupcao_teclado)) {
+    cpu_interrompe(self->cpu, IRQ_TECLADO);
+  }
+  if (controle_terminal_pede(self, terminal_interrupcao_tela)) {
+    cpu_interrompe(self->cpu, IRQ_TELA);
+  }
+}
+
+// retorna true se algum terminal está pedindo a interrupção testada por 'pede'
+static bool controle_terminal_pede(controle_t *self,
+                                   bool pede(terminal_t *))
+{
+  for (int t = 0; t < self->n_terminais; t++) {
+    if (pede(self->terminais[t])) return true;
+  }
+  return false;
+}
+
+// retorna true se a CPU está parada e nada mais pode acordá-la: o relógio
+//   não está pedindo interrupção e o timer está desligado, o disco não tem
+//   transferências pendentes e nenhum terminal vai pedir interrupção
+static bool controle_maquina_parada(controle_t *self)
+{
+  if (!cpu_parada(self->cpu)) return false;
+  if (disco_ocupado(self->disco) || disco_interrupcao(self->disco)) return false;
+  if (controle_terminal_pede(self, terminal_vai_interromper)) return false;
+  int tem_int, t_ate_int;
+  relogio_leitura(self->relogio, 3, &tem_int);
+  relogio_leitura(self->relogio, 2, &t_ate_int);
+  return tem_int == 0 && t_ate_int == 0;
+}
  
 
+void controle_estatisticas(controle_t *self, long *pt_parada,
+                           long *pt_parada_com_disco)
+{
+  *pt_parada = self->t_parada;
+  *pt_parada_com_disco = self->t_parada_com_disco;
+}
+
 static void controle_processa_comandos_da_console(controle_t *self)
 {
   char cmd = console_comando_externo(self->console);
@@ -89,7 +270,7 @@ static void controle_processa_comandos_da_console(controle_t *self)
 
 static void controle_atualiza_estado_na_console(controle_t *self)
 {
-  char status[100];
+  char status[160];
   switch (self->estado) {
     case fim:        strcpy(status, "FIM    | "); break;
     case parado:     strcpy(status, "PARADO | "); break;
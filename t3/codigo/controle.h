@@ -11,11 +11,27 @@ typedef struct controle_t controle_t;
 #include "cpu.h"
 #include "console.h"
 #include "relogio.h"
+#include "disco.h"
 
-controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio);
+controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio,
+                          disco_t *disco);
 void controle_destroi(controle_t *self);
 
 // o laço principal da simulação
 void controle_laco(controle_t *self);
 
+// o laço principal da simulação sem tela (execução em lote)
+// executa instruções sem parar, sem atender comandos da console, até que a
+//   CPU esteja parada sem nenhuma interrupção que possa acordá-la (o SO
+//   parou e desligou o timer)
+// para ser mais rápido, executa em lotes os tics entre eventos nos
+//   dispositivos (ver cpu_executa), com o mesmo resultado de um tic por vez
+void controle_laco_sem_tela(controle_t *self);
+
+// retorna o número de tics em que a CPU esteve parada, e quantos desses tics
+//   foram com o disco ocupado (tempo em que não houve sobreposição entre
+//   processamento e transferências de página)
+void controle_estatisticas(controle_t *self, long *pt_parada,
+                           long *pt_parada_com_disco);
+
 #endif // CONTROLE_H
@@ -23,6 +23,27 @@
 // DECLARAÇÃO {{{1
 // ---------------------------------------------------------------------
 
+// uma instrução já decodificada, pronta para ser executada
+// a CPU guarda uma para cada endereço físico da memória (ver DECODIFICAÇÃO)
+typedef struct {
+  // false se ainda não foi decodificada ou se a memória foi alterada depois
+  bool valida;
+  int opcode;
+  // argumento da instrução (0 se não tiver)
+  int A1;
+  // função que executa a instrução
+  void (*executa)(cpu_t *self, int A1);
+  // trecho de código que executa a instrução no núcleo rápido: o opcode,
+  //   N_OPCODE para instrução inválida, ou o de uma sequência que começa
+  //   nesta instrução (ver SEQUÊNCIAS DE INSTRUÇÕES)
+  int trecho;
+} instrucao_decodificada_t;
+
+// o núcleo de execução em lote (ver cpu_executa em cpu.h)
+#if defined(__GNUC__) && !defined(CPU_NUCLEO_REFERENCIA)
+#define CPU_NUCLEO_RAPIDO
+#endif
+
 // uma CPU tem estado, memória, controlador de ES
 struct cpu_t {
   // registradores
@@ -35,14 +56,35 @@ struct cpu_t {
   cpu_modo_t modo;
   // acesso a dispositivos externos
   mmu_t *mmu;
+  int tam_pagina;
   es_t *es;
   // identificação das instruções privilegiadas
   bool privilegiadas[N_OPCODE];
   // função e argumento para implementar instrução CHAMAC
   func_chamaC_t func_chamaC;
   void *arg_chamaC;
+  // instruções decodificadas, uma por endereço físico da memória
+  int n_decodificadas;
+  instrucao_decodificada_t *decodificadas;
+  // onde contar as instruções executadas, ou NULL
+  perfil_t *perfil;
+  // nomes dos endereços dos programas em cada modo, ou NULL
+  simbolos_t *simbolos_supervisor;
+  simbolos_t *simbolos_usuario;
+  // função e argumento para pôr os dispositivos em dia durante um lote
+  func_sincroniza_t func_sincroniza;
+  void *arg_sincroniza;
+  // instruções do lote atual iniciadas desde o início do lote ou desde a
+  //   última sincronização, incluindo a em execução
+  int lote_pendentes;
+  // true se o lote atual deve terminar depois da instrução em execução
+  bool lote_fim;
+  // onde escrever o estado antes de cada instrução, ou NULL
+  FILE *rastro;
 };
 
+static void cpu_invalida_decodificadas(void *arg, int endereco, int tam);
+
 
 // ---------------------------------------------------------------------
 // CRIAÇÃO {{{1
@@ -55,6 +97,7 @@ cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
   assert(self != NULL);
 
   self->mmu = mmu;
+  self->tam_pagina = mmu_tam_pagina(mmu);
   self->es = es;
 
   // inicializa registradores
@@ -66,6 +109,13 @@ cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
   self->complemento = 0;
   self->modo = supervisor;
   self->func_chamaC = NULL;
+  self->perfil = NULL;
+  self->simbolos_supervisor = NULL;
+  self->simbolos_usuario = NULL;
+  self->func_sincroniza = NULL;
+  self->lote_pendentes = 0;
+  self->lote_fim = false;
+  self->rastro = NULL;
 
   // inicializa instruções privilegiadas
   memset(self->privilegiadas, 0, sizeof(self->privilegiadas)); // todos em false
@@ -75,12 +125,22 @@ cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
   self->privilegiadas[RETI] = true;
   self->privilegiadas[CHAMAC] = true;
 
+  // inicializa as instruções decodificadas (todas inválidas), e pede para a
+  //   memória avisar quando for alterada, para invalidar as afetadas
+  mem_t *mem = mmu_memoria(mmu);
+  self->n_decodificadas = mem_tam(mem);
+  self->decodificadas = calloc(self->n_decodificadas, sizeof(*self->decodificadas));
+  assert(self->decodificadas != NULL);
+  mem_define_aviso_alteracao(mem, cpu_invalida_decodificadas, self);
+
   return self;
 }
 
 void cpu_destroi(cpu_t *self)
 {
   // quem criou mmu e e/s que destrua!
+  mem_define_aviso_alteracao(mmu_memoria(self->mmu), NULL, NULL);
+  free(self->decodificadas);
   free(self);
 }
 
@@ -102,10 +162,12 @@ static void formata_registradores(cpu_t *self, char *str)
                 self->PC, self->A, self->X);
 }
 
+// a leitura da instrução não pode ter efeito na MMU (ver mmu_examina), senão
+//   a execução com tela seria diferente da sem tela
 static void formata_instrucao(cpu_t *self, char *str)
 {
   int opcode;
-  if (mmu_le(self->mmu, self->PC, &opcode, self->modo) != ERR_OK) {
+  if (mmu_examina(self->mmu, self->PC, &opcode, self->modo) != ERR_OK) {
     strcpy(str, " PC inválido");
     return;
   }
@@ -114,7 +176,10 @@ static void formata_instrucao(cpu_t *self, char *str)
     // imprime argumento da instrução, se houver
   } else {
     int A1;
-    mmu_le(self->mmu, self->PC + 1, &A1, self->modo);
+    if (mmu_examina(self->mmu, self->PC + 1, &A1, self->modo) != ERR_OK) {
+      sprintf(str, " %02d %s ?", opcode, instrucao_nome(opcode));
+      return;
+    }
     sprintf(str, " %02d %s %d", opcode, instrucao_nome(opcode), A1);
   }
 }
@@ -129,6 +194,42 @@ static void formata_erro(cpu_t *self, char *str)
   }
 }
 
+// descreve o PC pelo label do programa em execução, se houver
+static void formata_simbolo(cpu_t *self, char *str, int tam)
+{
+  simbolos_t *simbolos = self->modo == supervisor ? self->simbolos_supervisor
+                                                  : self->simbolos_usuario;
+  int desloc;
+  if (simbolos == NULL || simbolos_nome(simbolos, self->PC, &desloc) == NULL) {
+    strcpy(str, "");
+    return;
+  }
+  str[0] = ' ';
+  simbolos_descreve(simbolos, self->PC, str + 1, tam - 1);
+}
+
+void cpu_define_perfil(cpu_t *self, perfil_t *perfil)
+{
+  self->perfil = perfil;
+}
+
+void cpu_define_simbolos(cpu_t *self, simbolos_t *supervisor, simbolos_t *usuario)
+{
+  self->simbolos_supervisor = supervisor;
+  self->simbolos_usuario = usuario;
+}
+
+void cpu_define_sincroniza(cpu_t *self, func_sincroniza_t func, void *arg)
+{
+  self->func_sincroniza = func;
+  self->arg_sincroniza = arg;
+}
+
+void cpu_define_rastro(cpu_t *self, FILE *arq)
+{
+  self->rastro = arq;
+}
+
 void cpu_concatena_descricao(cpu_t *self, char *str)
 {
   char aux[40];
@@ -141,6 +242,9 @@ void cpu_concatena_descricao(cpu_t *self, char *str)
 
   formata_erro(self, aux);
   strcat(str, aux);
+
+  formata_simbolo(self, aux, sizeof(aux));
+  strcat(str, aux);
 }
 
 
@@ -189,23 +293,18 @@ static bool poe_es(cpu_t *self, int dispositivo, int val)
   return false;
 }
 
-// lê o opcode da instrução no PC
-// retorna true se ele pode ser executado, ou põe em erro o motivo de não poder
-static bool pega_opcode(cpu_t *self, int *popc)
-{
-  // não pode executar se houver erro na leitura da memória
-  if (!pega_mem(self, self->PC, popc)) return false;
-  // pode executar se tiver privilégio para isso
-  if (self->modo == supervisor || !self->privilegiadas[*popc]) return true;
-  // não pode executar instrução privilegiada em modo usuário
-  self->erro = ERR_INSTR_PRIV;
-  return false;
-}
-
-// lê o argumento 1 da instrução no PC
-static bool pega_A1(cpu_t *self, int *pA1)
+// chamada antes de uma instrução que acessa os dispositivos: faz passar
+//   nos dispositivos o tempo das instruções anteriores do lote (ver
+//   cpu_executa), e termina o lote depois desta instrução, porque o acesso
+//   pode mudar quando os dispositivos vão pedir interrupção
+static void sincroniza_dispositivos(cpu_t *self)
 {
-  return pega_mem(self, self->PC + 1, pA1);
+  int anteriores = self->lote_pendentes - 1;
+  if (anteriores > 0 && self->func_sincroniza != NULL) {
+    self->func_sincroniza(self->arg_sincroniza, anteriores);
+    self->lote_pendentes = 1;
+  }
+  self->lote_fim = true;
 }
 
 
@@ -214,63 +313,60 @@ static bool pega_A1(cpu_t *self, int *pA1)
 // ---------------------------------------------------------------------
 
 // funções auxiliares para implementação de cada instrução
+// recebem o argumento A1 da instrução já lido da memória (ver DECODIFICAÇÃO)
+//   se a instrução não tem argumento, A1 é 0
 
-static void op_NOP(cpu_t *self) // não faz nada
+static void op_NOP(cpu_t *self, int A1) // não faz nada
 {
   self->PC += 1;
 }
 
-static void op_PARA(cpu_t *self) // para a CPU
+static void op_PARA(cpu_t *self, int A1) // para a CPU
 {
   self->erro = ERR_CPU_PARADA;
 }
 
-static void op_CARGI(cpu_t *self) // carrega imediato
+static void op_CARGI(cpu_t *self, int A1) // carrega imediato
 {
-  int A1;
-  if (pega_A1(self, &A1)) {
-    self->A = A1;
-    self->PC += 2;
-  }
+  self->A = A1;
+  self->PC += 2;
 }
 
-static void op_CARGM(cpu_t *self) // carrega da memória
+static void op_CARGM(cpu_t *self, int A1) // carrega da memória
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A = mA1;
     self->PC += 2;
   }
 }
 
-static void op_CARGX(cpu_t *self) // carrega indexado
+static void op_CARGX(cpu_t *self, int A1) // carrega indexado
 {
-  int A1, mA1mX;
+  int mA1mX;
   int X = self->X;
-  if (pega_A1(self, &A1) && pega_mem(self, A1 + X, &mA1mX)) {
+  if (pega_mem(self, A1 + X, &mA1mX)) {
     self->A = mA1mX;
     self->PC += 2;
   }
 }
 
-static void op_ARMM(cpu_t *self) // armazena na memória
+static void op_ARMM(cpu_t *self, int A1) // armazena na memória
 {
-  int A1;
-  if (pega_A1(self, &A1) && poe_mem(self, A1, self->A)) {
+  if (poe_mem(self, A1, self->A)) {
     self->PC += 2;
   }
 }
 
-static void op_ARMX(cpu_t *self) // armazena indexado
+static void op_ARMX(cpu_t *self, int A1) // armazena indexado
 {
-  int A1;
   int X = self->X;
-  if (pega_A1(self, &A1) && poe_mem(self, A1 + X, self->A)) {
+  if (poe_mem(self, A1 + X, self->A)) {
     self->PC += 2;
   }
 }
 
-static void op_TRAX(cpu_t *self) // troca A com X
+static void op_TRAX(cpu_t *self, int A1) // troca A com X
 {
   int A = self->A;
   int X = self->X;
@@ -279,142 +375,139 @@ static void op_TRAX(cpu_t *self) // troca A com X
   self->PC += 1;
 }
 
-static void op_CPXA(cpu_t *self) // copia X para A
+static void op_CPXA(cpu_t *self, int A1) // copia X para A
 {
   self->A = self->X;
   self->PC += 1;
 }
 
-static void op_INCX(cpu_t *self) // incrementa X
+static void op_INCX(cpu_t *self, int A1) // incrementa X
 {
   self->X += 1;
   self->PC += 1;
 }
 
-static void op_SOMA(cpu_t *self) // soma
+static void op_SOMA(cpu_t *self, int A1) // soma
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A += mA1;
     self->PC += 2;
   }
 }
 
-static void op_SUB(cpu_t *self) // subtração
+static void op_SUB(cpu_t *self, int A1) // subtração
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A -= mA1;
     self->PC += 2;
   }
 }
 
-static void op_MULT(cpu_t *self) // multiplicação
+static void op_MULT(cpu_t *self, int A1) // multiplicação
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A *= mA1;
     self->PC += 2;
   }
 }
 
-static void op_DIV(cpu_t *self) // divisão
+static void op_DIV(cpu_t *self, int A1) // divisão
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A /= mA1;
     self->PC += 2;
   }
 }
 
-static void op_RESTO(cpu_t *self) // resto
+static void op_RESTO(cpu_t *self, int A1) // resto
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->A %= mA1;
     self->PC += 2;
   }
 }
 
-static void op_NEG(cpu_t *self) // inverte sinal
+static void op_NEG(cpu_t *self, int A1) // inverte sinal
 {
   self->A = -self->A;
   self->PC += 1;
 }
 
-static void op_DESV(cpu_t *self) // desvio incondicional
+static void op_DESV(cpu_t *self, int A1) // desvio incondicional
 {
-  int A1;
-  if (pega_A1(self, &A1)) {
-    self->PC = A1;
-  }
+  self->PC = A1;
 }
 
-static void op_DESVZ(cpu_t *self) // desvio condicional
+static void op_DESVZ(cpu_t *self, int A1) // desvio condicional
 {
   if (self->A == 0) {
-    op_DESV(self);
+    op_DESV(self, A1);
   } else {
     self->PC += 2;
   }
 }
 
-static void op_DESVNZ(cpu_t *self) // desvio condicional
+static void op_DESVNZ(cpu_t *self, int A1) // desvio condicional
 {
   if (self->A != 0) {
-    op_DESV(self);
+    op_DESV(self, A1);
   } else {
     self->PC += 2;
   }
 }
 
-static void op_DESVN(cpu_t *self) // desvio condicional
+static void op_DESVN(cpu_t *self, int A1) // desvio condicional
 {
   if (self->A < 0) {
-    op_DESV(self);
+    op_DESV(self, A1);
   } else {
     self->PC += 2;
   }
 }
 
-static void op_DESVP(cpu_t *self) // desvio condicional
+static void op_DESVP(cpu_t *self, int A1) // desvio condicional
 {
   if (self->A > 0) {
-    op_DESV(self);
+    op_DESV(self, A1);
   } else {
     self->PC += 2;
   }
 }
 
-static void op_CHAMA(cpu_t *self) // chamada de subrotina
+static void op_CHAMA(cpu_t *self, int A1) // chamada de subrotina
 {
-  int A1;
-  if (pega_A1(self, &A1) && poe_mem(self, A1, self->PC + 2)) {
+  if (poe_mem(self, A1, self->PC + 2)) {
     self->PC = A1 + 1;
   }
 }
 
-static void op_RET(cpu_t *self) // retorno de subrotina
+static void op_RET(cpu_t *self, int A1) // retorno de subrotina
 {
-  int A1, mA1;
-  if (pega_A1(self, &A1) && pega_mem(self, A1, &mA1)) {
+  int mA1;
+  if (pega_mem(self, A1, &mA1)) {
     self->PC = mA1;
   }
 }
 
-static void op_LE(cpu_t *self) // leitura de E/S
+static void op_LE(cpu_t *self, int A1) // leitura de E/S
 {
-  int A1, dado;
-  if (pega_A1(self, &A1) && pega_es(self, A1, &dado)) {
+  sincroniza_dispositivos(self);
+  int dado;
+  if (pega_es(self, A1, &dado)) {
     self->A = dado;
     self->PC += 2;
   }
 }
 
-static void op_ESCR(cpu_t *self) // escrita de E/S
+static void op_ESCR(cpu_t *self, int A1) // escrita de E/S
 {
-  int A1;
-  if (pega_A1(self, &A1) && poe_es(self, A1, self->A)) {
+  sincroniza_dispositivos(self);
+  if (poe_es(self, A1, self->A)) {
     self->PC += 2;
   }
 }
@@ -422,13 +515,17 @@ static void op_ESCR(cpu_t *self) // escrita de E/S
 // RETI precisa de cpu_desinterrompe, que tá lá embaixo
 static void cpu_desinterrompe(cpu_t *self);
 
-static void op_RETI(cpu_t *self) // retorno de interrupção
+static void op_RETI(cpu_t *self, int A1) // retorno de interrupção
 {
   cpu_desinterrompe(self);
+  // termina o lote, porque interrupções pendentes podem ser aceitas agora
+  self->lote_fim = true;
 }
 
-static void op_CHAMAC(cpu_t *self) // chama função em C
+static void op_CHAMAC(cpu_t *self, int A1) // chama função em C
 {
+  // a função (o SO) acessa os dispositivos
+  sincroniza_dispositivos(self);
   if (self->func_chamaC == NULL) {
     self->erro = ERR_OP_INV;
     return;
@@ -439,7 +536,7 @@ static void op_CHAMAC(cpu_t *self) // chama função em C
   self->PC += 1;
 }
 
-static void op_CHAMAS(cpu_t *self) // chamada de sistema
+static void op_CHAMAS(cpu_t *self, int A1) // chamada de sistema
 {
   self->PC += 1;
   // causa uma interrupção, para forçar a execução do SO
@@ -447,44 +544,268 @@ static void op_CHAMAS(cpu_t *self) // chamada de sistema
 
 }
 
+static void op_invalida(cpu_t *self, int A1) // opcode desconhecido
+{
+  self->erro = ERR_INSTR_INV;
+}
+
 
 // ---------------------------------------------------------------------
-// EXECUÇÃO DE UMA INSTRUÇÃO {{{1
+// SEQUÊNCIAS DE INSTRUÇÕES {{{1
 // ---------------------------------------------------------------------
 
-static void executa_a_instrucao(cpu_t *self, int opcode)
+// O núcleo rápido (ver EXECUÇÃO EM LOTE) executa cada instrução em um trecho
+//   de código escolhido pelo campo 'trecho' da instrução decodificada: o
+//   trecho do opcode, ou o de uma sequência frequente de instruções sem
+//   desvio no meio, que tem o código das instruções uma depois da outra.
+// A sequência é reconhecida quando a primeira instrução é decodificada,
+//   olhando os opcodes seguintes na memória física, no mesmo quadro. Isso é
+//   só uma previsão: durante a execução, cada instrução seguinte é buscada e
+//   conferida, e se a memória mudou e não é mais a esperada, é executada a
+//   instrução que estiver lá.
+// O que se economiza é só o desvio indireto entre as instruções da
+//   sequência, não a busca: cada uma continua sendo traduzida pela MMU,
+//   contada no perfil e no rastro, porque a tradução tem efeitos visíveis
+//   (acertos e falhas da TLB, bit de acesso da página) que têm que ser os
+//   mesmos de cpu_executa_1.
+// As sequências são fixas, porque cada uma precisa de um trecho em
+//   cpu_executa; foram escolhidas entre as mais executadas nos programas de
+//   exemplo (o perfil mostra as instruções mais executadas), e são
+//   reconhecidas em qualquer lugar do código que for decodificado.
+
+#ifdef CPU_NUCLEO_RAPIDO
+
+// os trechos além dos opcodes: o de instrução inválida e o de cada
+//   sequência
+enum {
+  T_INVALIDA = N_OPCODE,
+  T_TRAX_CARGI_CHAMAS,
+  T_CARGI_TRAX,
+  T_CARGM_TRAX,
+  T_TRAX_ARMM,
+  T_INCX_CPXA,
+  T_SUB_DESVNZ,
+  T_RESTO_DESVNZ,
+  N_TRECHOS
+};
+
+#define SEQUENCIA_TAM_MAX 3
+
+typedef struct {
+  int trecho;
+  int n;
+  int opcodes[SEQUENCIA_TAM_MAX];
+} sequencia_t;
+
+// as sequências, as mais longas antes das que começam igual
+static const sequencia_t sequencias[] = {
+  { T_TRAX_CARGI_CHAMAS, 3, { TRAX, CARGI, CHAMAS } },  // chamada de sistema
+  { T_CARGI_TRAX,        2, { CARGI, TRAX } },          // X = constante
+  { T_CARGM_TRAX,        2, { CARGM, TRAX } },          // X = v
+  { T_TRAX_ARMM,         2, { TRAX, ARMM } },           // v = X
+  { T_INCX_CPXA,         2, { INCX, CPXA } },           // contador em X
+  { T_SUB_DESVNZ,        2, { SUB, DESVNZ } },          // fim de laço
+  { T_RESTO_DESVNZ,      2, { RESTO, DESVNZ } },        // múltiplo
+};
+#define N_SEQUENCIAS (int)(sizeof(sequencias) / sizeof(sequencias[0]))
+
+// retorna o trecho que executa a instrução 'instr', que começa no endereço
+//   físico 'endfis': o de uma sequência, se as instruções seguintes, no
+//   mesmo quadro, formarem uma, ou o da própria instrução
+static int reconhece_sequencia(cpu_t *self, instrucao_decodificada_t *instr,
+                               int endfis)
+{
+  mem_t *mem = mmu_memoria(self->mmu);
+  int fim_quadro = (endfis / self->tam_pagina + 1) * self->tam_pagina;
+  for (int s = 0; s < N_SEQUENCIAS; s++) {
+    const sequencia_t *si = &sequencias[s];
+    if (si->opcodes[0] != instr->opcode) continue;
+    int end = endfis;
+    int i;
+    for (i = 1; i < si->n; i++) {
+      int opcode;
+      end += 1 + instrucao_num_args(si->opcodes[i - 1]);
+      if (end >= fim_quadro || mem_le(mem, end, &opcode) != ERR_OK
+          || opcode != si->opcodes[i]) {
+        break;
+      }
+    }
+    if (i == si->n) return si->trecho;
+  }
+  return instr->trecho;
+}
+
+#endif // CPU_NUCLEO_RAPIDO
+
+
+// ---------------------------------------------------------------------
+// DECODIFICAÇÃO {{{1
+// ---------------------------------------------------------------------
+
+// A CPU guarda, para cada endereço físico da memória, a instrução que começa
+//   nesse endereço já decodificada (opcode, argumento e função que a executa),
+//   para não ter que ler e decodificar de novo a cada execução.
+// Como é indexada pelo endereço físico, não é afetada por trocas de tabela de
+//   páginas nem por remapeamento de páginas: o conteúdo de um endereço físico
+//   só muda quando a memória é escrita, e a memória avisa a CPU de cada
+//   alteração (ver cpu_invalida_decodificadas).
+// Uma instrução com argumento que está no último endereço de uma página não é
+//   guardada, porque o argumento está em outra página, que pode ser mapeada
+//   em outro quadro (ou não estar mapeada) na próxima execução.
+
+// função que executa cada instrução, indexado pelo opcode
+static void (*executores[N_OPCODE])(cpu_t *self, int A1) = {
+  [NOP]    = op_NOP,
+  [PARA]   = op_PARA,
+  [CARGI]  = op_CARGI,
+  [CARGM]  = op_CARGM,
+  [CARGX]  = op_CARGX,
+  [ARMM]   = op_ARMM,
+  [ARMX]   = op_ARMX,
+  [TRAX]   = op_TRAX,
+  [CPXA]   = op_CPXA,
+  [INCX]   = op_INCX,
+  [SOMA]   = op_SOMA,
+  [SUB]    = op_SUB,
+  [MULT]   = op_MULT,
+  [DIV]    = op_DIV,
+  [RESTO]  = op_RESTO,
+  [NEG]    = op_NEG,
+  [DESV]   = op_DESV,
+  [DESVZ]  = op_DESVZ,
+  [DESVNZ] = op_DESVNZ,
+  [DESVN]  = op_DESVN,
+  [DESVP]  = op_DESVP,
+  [CHAMA]  = op_CHAMA,
+  [RET]    = op_RET,
+  [LE]     = op_LE,
+  [ESCR]   = op_ESCR,
+  [RETI]   = op_RETI,
+  [CHAMAC] = op_CHAMAC,
+  [CHAMAS] = op_CHAMAS,
+};
+
+// chamada pela memória a cada alteração de conteúdo
+// invalida as instruções decodificadas que usam os endereços alterados,
+//   inclusive a que começa no endereço anterior (que pode ter o argumento
+//   no primeiro endereço alterado)
+static void cpu_invalida_decodificadas(void *arg, int endereco, int tam)
+{
+  cpu_t *self = arg;
+  int ini = endereco - 1;
+  int fim = endereco + tam;
+  if (ini < 0) ini = 0;
+  if (fim > self->n_decodificadas) fim = self->n_decodificadas;
+  for (int end = ini; end < fim; end++) {
+    self->decodificadas[end].valida = false;
+  }
+}
+
+// retorna true se o argumento da instrução no PC (se houver) está na mesma
+//   página que ela
+static bool argumento_na_mesma_pagina(cpu_t *self)
+{
+  return (self->PC + 1) % self->tam_pagina != 0;
+}
+
+// retorna true se 'opcode' é um desvio condicional que não é tomado com o
+//   valor atual de A
+static bool desvio_nao_tomado(cpu_t *self, int opcode)
 {
   switch (opcode) {
-    case NOP:    op_NOP(self);    break;
-    case PARA:   op_PARA(self);   break;
-    case CARGI:  op_CARGI(self);  break;
-    case CARGM:  op_CARGM(self);  break;
-    case CARGX:  op_CARGX(self);  break;
-    case ARMM:   op_ARMM(self);   break;
-    case ARMX:   op_ARMX(self);   break;
-    case TRAX:   op_TRAX(self);   break;
-    case CPXA:   op_CPXA(self);   break;
-    case INCX:   op_INCX(self);   break;
-    case SOMA:   op_SOMA(self);   break;
-    case SUB:    op_SUB(self);    break;
-    case MULT:   op_MULT(self);   break;
-    case DIV:    op_DIV(self);    break;
-    case RESTO:  op_RESTO(self);  break;
-    case NEG:    op_NEG(self);    break;
-    case DESV:   op_DESV(self);   break;
-    case DESVZ:  op_DESVZ(self);  break;
-    case DESVNZ: op_DESVNZ(self); break;
-    case DESVN:  op_DESVN(self);  break;
-    case DESVP:  op_DESVP(self);  break;
-    case CHAMA:  op_CHAMA(self);  break;
-    case RET:    op_RET(self);    break;
-    case LE:     op_LE(self);     break;
-    case ESCR:   op_ESCR(self);   break;
-    case RETI:   op_RETI(self);   break;
-    case CHAMAC: op_CHAMAC(self); break;
-    case CHAMAS: op_CHAMAS(self); break;
-    default:     self->erro = ERR_INSTR_INV;
+    case DESVZ:  return self->A != 0;
+    case DESVNZ: return self->A == 0;
+    case DESVN:  return self->A >= 0;
+    case DESVP:  return self->A <= 0;
+    default:     return false;
+  }
+}
+
+// lê e decodifica a instrução no PC, colocando o resultado em 'instr'
+// retorna true se ela pode ser executada, ou põe em erro o motivo de não poder
+static bool decodifica(cpu_t *self, instrucao_decodificada_t *instr)
+{
+  int opcode;
+  // não pode executar se houver erro na leitura da memória
+  if (!pega_mem(self, self->PC, &opcode)) return false;
+  if (opcode < 0 || opcode >= N_OPCODE || executores[opcode] == NULL) {
+    instr->opcode = opcode;
+    instr->A1 = 0;
+    instr->executa = op_invalida;
+    instr->trecho = N_OPCODE;
+    return true;
+  }
+  // não pode executar instrução privilegiada em modo usuário
+  if (self->modo == usuario && self->privilegiadas[opcode]) {
+    self->erro = ERR_INSTR_PRIV;
+    return false;
   }
+  instr->opcode = opcode;
+  instr->A1 = 0;
+  instr->executa = executores[opcode];
+  instr->trecho = opcode;
+  // o argumento de um desvio condicional que não é tomado não é lido se estiver
+  //   na página seguinte, que pode não estar na memória (a leitura causaria uma
+  //   falta de página); uma instrução assim não é guardada (ver
+  //   pega_instrucao), e é executada logo, com o mesmo A
+  if (instrucao_num_args(opcode) == 1
+      && (argumento_na_mesma_pagina(self) || !desvio_nao_tomado(self, opcode))) {
+    if (!pega_mem(self, self->PC + 1, &instr->A1)) return false;
+  }
+  return true;
+}
+
+// obtém a instrução no PC, decodificada, e coloca em '*pendfis' o endereço
+//   físico do PC
+// retorna um ponteiro para a instrução guardada para o endereço físico do PC,
+//   decodificando-a se necessário, ou para 'aux' se ela não puder ser guardada
+// retorna NULL se a instrução não pode ser executada (e põe em erro o motivo)
+static instrucao_decodificada_t *pega_instrucao(cpu_t *self,
+                                                instrucao_decodificada_t *aux,
+                                                int *pendfis)
+{
+  int endfis;
+  self->erro = mmu_traduz(self->mmu, self->PC, &endfis, self->modo);
+  *pendfis = endfis;
+  if (self->erro != ERR_OK) {
+    self->complemento = self->PC;
+    return NULL;
+  }
+  instrucao_decodificada_t *instr = &self->decodificadas[endfis];
+  if (instr->valida) {
+    // a decodificação não depende do modo, mas o privilégio sim
+    // (o opcode de uma instrução inválida pode estar fora da tabela)
+    if (self->modo == usuario && instr->executa != op_invalida
+        && self->privilegiadas[instr->opcode]) {
+      self->erro = ERR_INSTR_PRIV;
+      return NULL;
+    }
+    return instr;
+  }
+  // não está decodificada -- decodifica
+  if (!decodifica(self, aux)) return NULL;
+  // guarda, se o argumento (se houver) estiver na mesma página
+  if (instrucao_num_args(aux->opcode) != 1 || argumento_na_mesma_pagina(self)) {
+    *instr = *aux;
+    instr->valida = true;
+#ifdef CPU_NUCLEO_RAPIDO
+    instr->trecho = reconhece_sequencia(self, instr, endfis);
+#endif
+    return instr;
+  }
+  return aux;
+}
+
+
+// ---------------------------------------------------------------------
+// EXECUÇÃO DE UMA INSTRUÇÃO {{{1
+// ---------------------------------------------------------------------
+
+// escreve o estado da CPU antes de uma instrução no rastro
+static void registra_rastro(cpu_t *self)
+{
+  fprintf(self->rastro, "%c %d %d %d\n", self->modo == supervisor ? 'S' : 'u',
+          self->PC, self->A, self->X);
 }
 
 void cpu_executa_1(cpu_t *self)
@@ -492,9 +813,17 @@ void cpu_executa_1(cpu_t *self)
   // não executa se CPU já estiver em erro
   if (self->erro != ERR_OK) return;
 
-  int opcode;
-  if (pega_opcode(self, &opcode)) {
-    executa_a_instrucao(self, opcode);
+  if (self->rastro != NULL) registra_rastro(self);
+
+  instrucao_decodificada_t aux;
+  int endfis;
+  instrucao_decodificada_t *instr = pega_instrucao(self, &aux, &endfis);
+  if (instr != NULL) {
+    if (self->perfil != NULL) {
+      perfil_conta(self->perfil, instr->opcode, endfis, self->PC,
+                   self->modo == usuario);
+    }
+    instr->executa(self, instr->A1);
   }
 
   // se a CPU entrou em erro, causa uma interrupção
@@ -509,15 +838,357 @@ void cpu_executa_1(cpu_t *self)
   }
 }
 
+bool cpu_parada(cpu_t *self)
+{
+  return self->erro == ERR_CPU_PARADA;
+}
+
+
+// ---------------------------------------------------------------------
+// EXECUÇÃO EM LOTE {{{1
+// ---------------------------------------------------------------------
+
+#ifndef CPU_NUCLEO_RAPIDO
+
+// núcleo de referência: uma instrução por vez, com cpu_executa_1
+int cpu_executa(cpu_t *self, int n)
+{
+  int feitas = 0;
+  self->lote_fim = false;
+  while (feitas < n && !self->lote_fim && !cpu_parada(self)) {
+    feitas++;
+    self->lote_pendentes++;
+    cpu_executa_1(self);
+  }
+  self->lote_pendentes = 0;
+  return feitas;
+}
+
+#else // núcleo com "threaded code"
+
+// O núcleo rápido executa o lote todo dentro de uma função, sem uma chamada
+//   por instrução: o código de cada instrução é um trecho da função, marcado
+//   por um label, e termina desviando diretamente para o trecho da próxima
+//   instrução (goto calculado, com o endereço do label obtido de uma tabela
+//   indexada pelo trecho da instrução decodificada).
+// Cada trecho tem a sua cópia do código que busca e despacha a próxima
+//   instrução (DESPACHA), para que o desvio indireto de cada uma seja previsto
+//   separadamente pelo processador que executa o simulador.
+// O trecho de uma sequência (ver SEQUÊNCIAS DE INSTRUÇÕES) executa a primeira
+//   instrução, e busca cada uma das seguintes da forma normal (SEGUE); se ela
+//   é a esperada, continua no mesmo trecho, sem o desvio indireto, senão
+//   despacha normalmente. Cada instrução da sequência é buscada, contada e
+//   executada como se não estivesse em uma sequência, e o lote pode
+//   terminar ou ser interrompido no meio dela.
+// A busca da instrução (pega_instrucao, com a tradução pela MMU), o perfil,
+//   o rastro e o tratamento de erro são os mesmos de cpu_executa_1, e as
+//   instruções pouco executadas usam as mesmas funções op_*; as outras têm o
+//   código repetido aqui (nas macros I_*), e devem ter exatamente o efeito
+//   das funções op_* correspondentes (verifica_nucleo.sh compara os dois
+//   núcleos).
+
+// conta a instrução no perfil, como em cpu_executa_1
+static void conta_no_perfil(cpu_t *self, instrucao_decodificada_t *instr,
+                            int endfis)
+{
+  perfil_conta(self->perfil, instr->opcode, endfis, self->PC,
+               self->modo == usuario);
+}
+
+int cpu_executa(cpu_t *self, int n)
+{
+  // o código de cada trecho (ver SEQUÊNCIAS DE INSTRUÇÕES); os códigos que não são
+  //   instrução vão para o trecho de instrução inválida
+  static void *const trechos[N_TRECHOS] = {
+    [0 ... N_OPCODE - 1] = &&t_invalida,
+    [T_INVALIDA] = &&t_invalida,
+    [NOP]    = &&t_NOP,
+    [PARA]   = &&t_PARA,
+    [CARGI]  = &&t_CARGI,
+    [CARGM]  = &&t_CARGM,
+    [CARGX]  = &&t_CARGX,
+    [ARMM]   = &&t_ARMM,
+    [ARMX]   = &&t_ARMX,
+    [TRAX]   = &&t_TRAX,
+    [CPXA]   = &&t_CPXA,
+    [INCX]   = &&t_INCX,
+    [SOMA]   = &&t_SOMA,
+    [SUB]    = &&t_SUB,
+    [MULT]   = &&t_MULT,
+    [DIV]    = &&t_DIV,
+    [RESTO]  = &&t_RESTO,
+    [NEG]    = &&t_NEG,
+    [DESV]   = &&t_DESV,
+    [DESVZ]  = &&t_DESVZ,
+    [DESVNZ] = &&t_DESVNZ,
+    [DESVN]  = &&t_DESVN,
+    [DESVP]  = &&t_DESVP,
+    [CHAMA]  = &&t_CHAMA,
+    [RET]    = &&t_RET,
+    [LE]     = &&t_LE,
+    [ESCR]   = &&t_ESCR,
+    [RETI]   = &&t_RETI,
+    [CHAMAC] = &&t_CHAMAC,
+    [CHAMAS] = &&t_CHAMAS,
+    [T_TRAX_CARGI_CHAMAS] = &&t_TRAX_CARGI_CHAMAS,
+    [T_CARGI_TRAX]        = &&t_CARGI_TRAX,
+    [T_CARGM_TRAX]        = &&t_CARGM_TRAX,
+    [T_TRAX_ARMM]         = &&t_TRAX_ARMM,
+    [T_INCX_CPXA]         = &&t_INCX_CPXA,
+    [T_SUB_DESVNZ]        = &&t_SUB_DESVNZ,
+    [T_RESTO_DESVNZ]      = &&t_RESTO_DESVNZ,
+  };
+  instrucao_decodificada_t aux, *instr;
+  int endfis, A1, val;
+  int feitas = 0;
+
+  // busca a próxima instrução, ou termina o lote
+#define BUSCA()                                                        \
+  do {                                                                 \
+    if (feitas == n || self->lote_fim) goto fim;                       \
+    feitas++;                                                          \
+    self->lote_pendentes++;                                            \
+    if (self->rastro != NULL) registra_rastro(self);                   \
+    instr = pega_instrucao(self, &aux, &endfis);                       \
+    if (instr == NULL) goto erro;                                      \
+    if (self->perfil != NULL) conta_no_perfil(self, instr, endfis);    \
+    A1 = instr->A1;                                                    \
+  } while (0)
+  // busca a próxima instrução e desvia para o seu trecho
+#define DESPACHA()                                                     \
+  do {                                                                 \
+    BUSCA();                                                           \
+    goto *trechos[instr->trecho];                                      \
+  } while (0)
+  // fim do trecho de uma instrução
+#define PROXIMA()                                                      \
+  do {                                                                 \
+    if (self->erro != ERR_OK) goto erro;                               \
+    DESPACHA();                                                        \
+  } while (0)
+  // no meio de uma sequência: busca a próxima instrução, e continua
+  //   no trecho se ela tem o opcode 'op', senão desvia para o trecho dela
+#define SEGUE(op)                                                      \
+  do {                                                                 \
+    if (self->erro != ERR_OK) goto erro;                               \
+    BUSCA();                                                           \
+    if (instr->opcode != (op)) goto *trechos[instr->trecho];           \
+  } while (0)
+
+  // o efeito das instruções executadas aqui
+#define I_CARGI do { self->A = A1; self->PC += 2; } while (0)
+#define I_CARGM                                                        \
+  do {                                                                 \
+    if (pega_mem(self, A1, &val)) {                                    \
+      self->A = val;                                                   \
+      self->PC += 2;                                                   \
+    }                                                                  \
+  } while (0)
+#define I_CARGX                                                        \
+  do {                                                                 \
+    if (pega_mem(self, A1 + self->X, &val)) {                          \
+      self->A = val;                                                   \
+      self->PC += 2;                                                   \
+    }                                                                  \
+  } while (0)
+#define I_ARMM do { if (poe_mem(self, A1, self->A)) self->PC += 2; } while (0)
+#define I_ARMX                                                         \
+  do {                                                                 \
+    if (poe_mem(self, A1 + self->X, self->A)) self->PC += 2;           \
+  } while (0)
+#define I_TRAX                                                         \
+  do {                                                                 \
+    val = self->A;                                                     \
+    self->A = self->X;                                                 \
+    self->X = val;                                                     \
+    self->PC += 1;                                                     \
+  } while (0)
+#define I_CPXA do { self->A = self->X; self->PC += 1; } while (0)
+#define I_INCX do { self->X += 1; self->PC += 1; } while (0)
+  // SOMA, SUB e MULT
+#define I_ARIT(oper)                                                   \
+  do {                                                                 \
+    if (pega_mem(self, A1, &val)) {                                    \
+      self->A oper val;                                                \
+      self->PC += 2;                                                   \
+    }                                                                  \
+  } while (0)
+#define I_DESVNZ do { self->PC = self->A != 0 ? A1 : self->PC + 2; } while (0)
+
+  self->lote_fim = false;
+  if (cpu_parada(self)) goto fim;
+  DESPACHA();
+
+t_NOP:
+  self->PC += 1;
+  PROXIMA();
+t_PARA:
+  op_PARA(self, A1);
+  PROXIMA();
+t_CARGI:
+  I_CARGI;
+  PROXIMA();
+t_CARGM:
+  I_CARGM;
+  PROXIMA();
+t_CARGX:
+  I_CARGX;
+  PROXIMA();
+t_ARMM:
+  I_ARMM;
+  PROXIMA();
+t_ARMX:
+  I_ARMX;
+  PROXIMA();
+t_TRAX:
+  I_TRAX;
+  PROXIMA();
+t_CPXA:
+  I_CPXA;
+  PROXIMA();
+t_INCX:
+  I_INCX;
+  PROXIMA();
+t_SOMA:
+  I_ARIT(+=);
+  PROXIMA();
+t_SUB:
+  I_ARIT(-=);
+  PROXIMA();
+t_MULT:
+  I_ARIT(*=);
+  PROXIMA();
+t_DIV:
+  op_DIV(self, A1);
+  PROXIMA();
+t_RESTO:
+  op_RESTO(self, A1);
+  PROXIMA();
+t_NEG:
+  self->A = -self->A;
+  self->PC += 1;
+  PROXIMA();
+t_DESV:
+  self->PC = A1;
+  PROXIMA();
+t_DESVZ:
+  self->PC = self->A == 0 ? A1 : self->PC + 2;
+  PROXIMA();
+t_DESVNZ:
+  I_DESVNZ;
+  PROXIMA();
+t_DESVN:
+  self->PC = self->A < 0 ? A1 : self->PC + 2;
+  PROXIMA();
+t_DESVP:
+  self->PC = self->A > 0 ? A1 : self->PC + 2;
+  PROXIMA();
+t_CHAMA:
+  if (poe_mem(self, A1, self->PC + 2)) self->PC = A1 + 1;
+  PROXIMA();
+t_RET:
+  if (pega_mem(self, A1, &val)) self->PC = val;
+  PROXIMA();
+t_LE:
+  op_LE(self, A1);
+  PROXIMA();
+t_ESCR:
+  op_ESCR(self, A1);
+  PROXIMA();
+t_RETI:
+  op_RETI(self, A1);
+  PROXIMA();
+t_CHAMAC:
+  op_CHAMAC(self, A1);
+  PROXIMA();
+t_CHAMAS:
+  op_CHAMAS(self, A1);
+  PROXIMA();
+t_invalida:
+  op_invalida(self, A1);
+  PROXIMA();
+
+  // as sequências
+t_TRAX_CARGI_CHAMAS:
+  I_TRAX;
+  SEGUE(CARGI);
+  I_CARGI;
+  SEGUE(CHAMAS);
+  op_CHAMAS(self, A1);
+  PROXIMA();
+t_CARGI_TRAX:
+  I_CARGI;
+  SEGUE(TRAX);
+  I_TRAX;
+  PROXIMA();
+t_CARGM_TRAX:
+  I_CARGM;
+  SEGUE(TRAX);
+  I_TRAX;
+  PROXIMA();
+t_TRAX_ARMM:
+  I_TRAX;
+  SEGUE(ARMM);
+  I_ARMM;
+  PROXIMA();
+t_INCX_CPXA:
+  I_INCX;
+  SEGUE(CPXA);
+  I_CPXA;
+  PROXIMA();
+t_SUB_DESVNZ:
+  I_ARIT(-=);
+  SEGUE(DESVNZ);
+  I_DESVNZ;
+  PROXIMA();
+t_RESTO_DESVNZ:
+  op_RESTO(self, A1);
+  SEGUE(DESVNZ);
+  I_DESVNZ;
+  PROXIMA();
+
+erro:
+  // como em cpu_executa_1: a CPU parada termina o lote, outro erro causa
+  //   uma interrupção e o lote continua no tratador
+  if (cpu_parada(self)) goto fim;
+  assert(cpu_interrompe(self, IRQ_ERR_CPU));
+  DESPACHA();
+
+fim:
+#undef I_DESVNZ
+#undef I_ARIT
+#undef I_INCX
+#undef I_CPXA
+#undef I_TRAX
+#undef I_ARMX
+#undef I_ARMM
+#undef I_CARGX
+#undef I_CARGM
+#undef I_CARGI
+#undef SEGUE
+#undef PROXIMA
+#undef DESPACHA
+#undef BUSCA
+  self->lote_pendentes = 0;
+  return feitas;
+}
+
+#endif // CPU_NUCLEO_RAPIDO
+
 
 // ---------------------------------------------------------------------
 // INTERRUPÇÃO {{{1
 // ---------------------------------------------------------------------
 
-bool cpu_interrompe(cpu_t *self, irq_t irq)
+bool cpu_aceita_interrupcao(cpu_t *self)
 {
   // só aceita interrupção em modo usuário ou quando a CPU está dormindo
-  if (self->modo != usuario && self->erro != ERR_CPU_PARADA) return false;
+  return self->modo == usuario || self->erro == ERR_CPU_PARADA;
+}
+
+bool cpu_interrompe(cpu_t *self, irq_t irq)
+{
+  if (!cpu_aceita_interrupcao(self)) return false;
 
   // Copia o estado da CPU para variáveis locais, para ter certeza que nada será
   //   alterado por funções auxiliares (poe_mem altera o erro)
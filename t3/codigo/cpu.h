@@ -33,10 +33,20 @@ typedef enum { supervisor, usuario } cpu_modo_t;
 #include "es.h"
 #include "irq.h"
 #include "mmu.h"
+#include "perfil.h"
+#include "simbolos.h"
+
+#include <stdio.h>
 
 // tipo da função a ser chamada quando executar a instrução CHAMAC
 typedef int (*func_chamaC_t)(void *argC, int reg_A);
 
+// tipo da função chamada por cpu_executa antes de uma instrução que acessa os
+//   dispositivos (LE, ESCR e CHAMAC), com o número de instruções do lote já
+//   executadas desde o início do lote ou desde a chamada anterior, para que
+//   o tempo correspondente a elas passe nos dispositivos antes do acesso
+typedef void (*func_sincroniza_t)(void *arg, int n_instrucoes);
+
 
 // cria uma unidade de execução com acesso à MMU e ao
 //   controlador de E/S fornecidos
@@ -51,6 +61,28 @@ void cpu_destroi(cpu_t *self);
 //     e causa uma interrupção
 void cpu_executa_1(cpu_t *self);
 
+// executa um lote de até 'n' instruções, com o mesmo efeito de chamar
+//   cpu_executa_1 'n' vezes sem que o tempo passe nos dispositivos entre elas
+// o lote termina antes se a CPU parar, logo depois de uma instrução que
+//   acessa os dispositivos (antes dela, é chamada a função de sincronização)
+//   ou depois de RETI (a CPU volta a aceitar interrupções)
+// retorna o número de instruções executadas (as que causaram erro contam)
+// há dois núcleos de execução, escolhidos na compilação: o de referência,
+//   que chama cpu_executa_1, e um mais rápido, com despacho por "threaded
+//   code" (goto calculado, extensão do gcc), que passa sem desvio indireto
+//   entre as instruções de algumas sequências frequentes (ver cpu.c); é
+//   usado por padrão quando o compilador permite; para usar o de referência:
+//     make clean; make CPPFLAGS=-DCPU_NUCLEO_REFERENCIA
+int cpu_executa(cpu_t *self, int n);
+
+// retorna true se a CPU está parada (executou a instrução PARA), dormindo
+//   até que venha uma interrupção
+bool cpu_parada(cpu_t *self);
+
+// retorna true se a CPU aceita interrupções no estado atual (está em modo
+//   usuário ou parada)
+bool cpu_aceita_interrupcao(cpu_t *self);
+
 // implementa uma interrupção
 // passa para modo supervisor, salva o estado da CPU no início da memória,
 //   altera A para identificar a requisição de interrupção, altera PC para
@@ -62,6 +94,24 @@ bool cpu_interrompe(cpu_t *self, irq_t irq);
 // e o argumento a passar para ela (normalmente, um ponteiro para o SO)
 void cpu_define_chamaC(cpu_t *self, func_chamaC_t func, void *argC);
 
+// define a função de sincronização usada por cpu_executa e o argumento a
+//   passar para ela (normalmente, um ponteiro para o controlador)
+void cpu_define_sincroniza(cpu_t *self, func_sincroniza_t func, void *arg);
+
+// define o perfil onde contar as instruções executadas (ver perfil.h), ou
+//   NULL para não contar (o padrão)
+void cpu_define_perfil(cpu_t *self, perfil_t *perfil);
+
+// define as tabelas de símbolos dos programas executados em modo supervisor e
+//   em modo usuário, para descrever o PC na descrição do estado da CPU
+// qualquer das duas pode ser NULL (o padrão), e o PC é descrito só pelo número
+void cpu_define_simbolos(cpu_t *self, simbolos_t *supervisor, simbolos_t *usuario);
+
+// define um arquivo onde escrever o modo e os registradores antes de cada
+//   instrução executada, uma linha por instrução, para comparar execuções
+//   (ver verifica_nucleo.sh), ou NULL para não escrever (o padrão)
+void cpu_define_rastro(cpu_t *self, FILE *arq);
+
 // concatena a descrição do estado da CPU no final de str
 void cpu_concatena_descricao(cpu_t *self, char *str);
 
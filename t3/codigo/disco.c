@@ -0,0 +1,212 @@
+// disco.c
+// dispositivo de E/S para transferência de páginas com a memória secundária
+// simulador de computador
+// so25b
+
+#include "disco.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+// um pedido de transferência
+typedef struct {
+  int comando;
+  int quadro;
+  int bloco;
+} pedido_t;
+
+struct disco_t {
+  mem_t *mem;
+  mem_t *mem2;
+  int tam_pagina;
+  int tempo_pagina;
+  // quadro e bloco do próximo pedido
+  int quadro;
+  int bloco;
+  // fila circular de pedidos não concluídos; o primeiro está sendo atendido
+  pedido_t *pedidos;
+  int cap_pedidos;
+  int n_pedidos;
+  int primeiro;
+  // tempo até concluir o primeiro pedido
+  int t_restante;
+  // pedidos concluídos e ainda não tratados pelo SO
+  int concluidos;
+  // estatísticas
+  long transferencias;
+  long t_ocupado;
+};
+
+disco_t *disco_cria(mem_t *mem, mem_t *mem2, int tam_pagina, int tempo_pagina)
+{
+  disco_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->mem = mem;
+  self->mem2 = mem2;
+  self->tam_pagina = tam_pagina;
+  self->tempo_pagina = tempo_pagina;
+  self->quadro = 0;
+  self->bloco = 0;
+  self->cap_pedidos = 8;
+  self->pedidos = malloc(self->cap_pedidos * sizeof(pedido_t));
+  assert(self->pedidos != NULL);
+  self->n_pedidos = 0;
+  self->primeiro = 0;
+  self->t_restante = 0;
+  self->concluidos = 0;
+  self->transferencias = 0;
+  self->t_ocupado = 0;
+  return self;
+}
+
+void disco_destroi(disco_t *self)
+{
+  free(self->pedidos);
+  free(self);
+}
+
+// coloca um pedido no fim da fila, aumentando a fila se necessário
+static void disco__insere_pedido(disco_t *self, pedido_t pedido)
+{
+  if (self->n_pedidos == self->cap_pedidos) {
+    // copia para o início de um vetor maior, desfazendo a volta
+    int cap = self->cap_pedidos * 2;
+    pedido_t *pedidos = malloc(cap * sizeof(pedido_t));
+    assert(pedidos != NULL);
+    for (int i = 0; i < self->n_pedidos; i++) {
+      pedidos[i] = self->pedidos[(self->primeiro + i) % self->cap_pedidos];
+    }
+    free(self->pedidos);
+    self->pedidos = pedidos;
+    self->cap_pedidos = cap;
+    self->primeiro = 0;
+  }
+  int pos = (self->primeiro + self->n_pedidos) % self->cap_pedidos;
+  self->pedidos[pos] = pedido;
+  self->n_pedidos++;
+  // se o disco estava parado, começa a atender o pedido
+  if (self->n_pedidos == 1) self->t_restante = self->tempo_pagina;
+}
+
+// realiza a transferência de um pedido
+static void disco__transfere(disco_t *self, pedido_t *pedido)
+{
+  mem_t *orig = self->mem2, *dest = self->mem;
+  int end_orig = pedido->bloco * self->tam_pagina;
+  int end_dest = pedido->quadro * self->tam_pagina;
+  if (pedido->comando == DISCO_ESCREVE) {
+    orig = self->mem;
+    dest = self->mem2;
+    end_orig = pedido->quadro * self->tam_pagina;
+    end_dest = pedido->bloco * self->tam_pagina;
+  }
+  // os endereços foram verificados quando o pedido foi feito
+  mem_copia(dest, end_dest, orig, end_orig, self->tam_pagina);
+}
+
+void disco_tictac(disco_t *self)
+{
+  if (self->n_pedidos == 0) return;
+  self->t_ocupado++;
+  self->t_restante--;
+  if (self->t_restante > 0) return;
+  disco__transfere(self, &self->pedidos[self->primeiro]);
+  self->transferencias++;
+  self->concluidos++;
+  self->primeiro = (self->primeiro + 1) % self->cap_pedidos;
+  self->n_pedidos--;
+  self->t_restante = self->tempo_pagina;
+}
+
+void disco_avanca(disco_t *self, int n)
+{
+  while (n > 0 && self->n_pedidos != 0) {
+    // avança até o fim do pedido atual ou do tempo, o que vier antes
+    int passo = n < self->t_restante ? n : self->t_restante;
+    self->t_ocupado += passo - 1;
+    self->t_restante -= passo - 1;
+    n -= passo;
+    disco_tictac(self);
+  }
+}
+
+int disco_tempo_ate_conclusao(disco_t *self)
+{
+  if (self->n_pedidos == 0) return 0;
+  return self->t_restante;
+}
+
+bool disco_interrupcao(disco_t *self)
+{
+  return self->concluidos != 0;
+}
+
+bool disco_ocupado(disco_t *self)
+{
+  return self->n_pedidos != 0;
+}
+
+void disco_estatisticas(disco_t *self, long *ptransferencias, long *pt_ocupado)
+{
+  *ptransferencias = self->transferencias;
+  *pt_ocupado = self->t_ocupado;
+}
+
+// retorna true se a página começando em 'pagina' cabe na memória
+static bool disco__pagina_valida(disco_t *self, mem_t *mem, int pagina)
+{
+  return pagina >= 0 && (pagina + 1) * self->tam_pagina <= mem_tam(mem);
+}
+
+err_t disco_leitura(void *disp, int id, int *pvalor)
+{
+  disco_t *self = disp;
+  err_t err = ERR_OK;
+  switch (id) {
+    case DISCO_QUADRO:
+      *pvalor = self->quadro;
+      break;
+    case DISCO_BLOCO:
+      *pvalor = self->bloco;
+      break;
+    case DISCO_COMANDO:
+      *pvalor = self->n_pedidos;
+      break;
+    case DISCO_CONCLUIDOS:
+      *pvalor = self->concluidos;
+      break;
+    default:
+      err = ERR_END_INV;
+  }
+  return err;
+}
+
+err_t disco_escrita(void *disp, int id, int valor)
+{
+  disco_t *self = disp;
+  err_t err = ERR_OK;
+  switch (id) {
+    case DISCO_QUADRO:
+      self->quadro = valor;
+      break;
+    case DISCO_BLOCO:
+      self->bloco = valor;
+      break;
+    case DISCO_COMANDO:
+      if (valor != DISCO_LE && valor != DISCO_ESCREVE) {
+        err = ERR_OP_INV;
+      } else if (!disco__pagina_valida(self, self->mem, self->quadro)
+                 || !disco__pagina_valida(self, self->mem2, self->bloco)) {
+        err = ERR_END_INV;
+      } else {
+        disco__insere_pedido(self, (pedido_t){ valor, self->quadro, self->bloco });
+      }
+      break;
+    case DISCO_CONCLUIDOS:
+      self->concluidos = valor;
+      break;
+    default:
+      err = ERR_END_INV;
+  }
+  return err;
+}
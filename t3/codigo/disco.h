@@ -0,0 +1,83 @@
+// disco.h
+// dispositivo de E/S para transferência de páginas com a memória secundária
+// simulador de computador
+// so25b
+
+#ifndef DISCO_H
+#define DISCO_H
+
+// simulador de um disco de paginação
+// o disco é a memória secundária, dividida em blocos do tamanho de uma página;
+//   ele transfere uma página por vez entre um bloco e um quadro da memória
+//   principal (por DMA), sem ocupar a CPU
+// os pedidos de transferência são atendidos em ordem de chegada (os pedidos
+//   feitos enquanto o disco está ocupado ficam em uma fila); cada transferência
+//   leva um tempo fixo (em tics do relógio)
+// quando uma transferência termina, o contador de pedidos concluídos é
+//   incrementado; enquanto esse contador não for zero, o disco pede interrupção
+//
+// tem 4 dispositivos:
+// - DISCO_QUADRO: lê ou escreve o quadro da memória principal do próximo pedido
+// - DISCO_BLOCO: lê ou escreve o bloco do disco do próximo pedido
+// - DISCO_COMANDO: escrever DISCO_LE (do disco para a memória principal) ou
+//   DISCO_ESCREVE (da memória principal para o disco) faz um pedido de
+//   transferência entre o quadro e o bloco; a leitura retorna o número de
+//   pedidos ainda não concluídos
+// - DISCO_CONCLUIDOS: lê ou escreve o número de pedidos concluídos (o SO deve
+//   zerá-lo depois de tratar os pedidos concluídos, para desligar a interrupção)
+
+#include "err.h"
+#include "memoria.h"
+
+#include <stdbool.h>
+
+typedef struct disco_t disco_t;
+
+// os 4 dispositivos do disco
+#define DISCO_QUADRO     0
+#define DISCO_BLOCO      1
+#define DISCO_COMANDO    2
+#define DISCO_CONCLUIDOS 3
+
+// os comandos do disco
+#define DISCO_LE         1
+#define DISCO_ESCREVE    2
+
+// cria um disco, que transfere páginas de 'tam_pagina' valores entre a memória
+//   principal 'mem' e a secundária 'mem2', levando 'tempo_pagina' tics em cada
+//   transferência
+disco_t *disco_cria(mem_t *mem, mem_t *mem2, int tam_pagina, int tempo_pagina);
+
+// destrói um disco
+// nenhuma outra operação pode ser realizada no disco após esta chamada
+void disco_destroi(disco_t *self);
+
+// registra a passagem de uma unidade de tempo
+// esta função é chamada pelo controlador após a execução de cada instrução
+void disco_tictac(disco_t *self);
+
+// registra a passagem de 'n' unidades de tempo, com o mesmo efeito de 'n'
+//   chamadas a disco_tictac
+void disco_avanca(disco_t *self, int n);
+
+// retorna quantas unidades de tempo faltam para o disco concluir o pedido
+//   sendo atendido, ou 0 se ele não tiver pedidos
+int disco_tempo_ate_conclusao(disco_t *self);
+
+// retorna true se o disco está pedindo interrupção
+bool disco_interrupcao(disco_t *self);
+
+// retorna true se o disco tem pedidos não concluídos
+bool disco_ocupado(disco_t *self);
+
+// retorna o número de transferências realizadas e o tempo em que o disco
+//   esteve ocupado
+void disco_estatisticas(disco_t *self, long *ptransferencias, long *pt_ocupado);
+
+// Funções para acessar o disco como dispositivo de E/S, com o id de cada
+//   dispositivo (DISCO_QUADRO etc)
+// Devem seguir o protocolo f_leitura_t e f_escrita_t declarados em es.h
+err_t disco_leitura(void *disp, int id, int *pvalor);
+err_t disco_escrita(void *disp, int id, int valor);
+
+#endif // DISCO_H
@@ -7,6 +7,7 @@
 #define DISPOSITIVOS_H
 
 #include "terminal.h"
+#include "disco.h"
 
 typedef enum {
   D_TERM_A,
@@ -33,6 +34,17 @@ typedef enum {
   D_RELOGIO_REAL,
   D_RELOGIO_TIMER,
   D_RELOGIO_INTERRUPCAO,
+  D_DISCO,
+  D_DISCO_QUADRO          =  D_DISCO + DISCO_QUADRO,
+  D_DISCO_BLOCO           =  D_DISCO + DISCO_BLOCO,
+  D_DISCO_COMANDO         =  D_DISCO + DISCO_COMANDO,
+  D_DISCO_CONCLUIDOS      =  D_DISCO + DISCO_CONCLUIDOS,
+  // as interrupções habilitadas de cada terminal (TERM_INTERRUPCAO) ficam
+  //   depois dos outros, para não mudar a numeração dos mais antigos
+  D_TERM_A_INTERRUPCAO,
+  D_TERM_B_INTERRUPCAO,
+  D_TERM_C_INTERRUPCAO,
+  D_TERM_D_INTERRUPCAO,
   N_DISPOSITIVOS
 } dispositivo_id_t;
 
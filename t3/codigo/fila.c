@@ -5,14 +5,28 @@
 #include <assert.h>
 
 
-static NoFila *no_cria(int dado) {
-    NoFila *n = (NoFila*) malloc(sizeof(NoFila));
-    assert(n != NULL);
+#define FILA_CAP_INICIAL 8
 
-    n->dado = dado;
-    n->prox = NULL;
 
-    return n;
+// posição no vetor do elemento na posição pos da fila
+static int fila_indice(Fila *self, int pos) {
+    return (self->pri + pos) % self->cap;
+}
+
+
+// dobra o tamanho do vetor, colocando os elementos no início
+static void fila_aumenta(Fila *self) {
+    int cap = self->cap * 2;
+    int *dados = (int*) malloc(cap * sizeof(int));
+    assert(dados != NULL);
+
+    for (int i = 0; i < self->n_elem; i++) {
+        dados[i] = self->dados[fila_indice(self, i)];
+    }
+    free(self->dados);
+    self->dados = dados;
+    self->cap = cap;
+    self->pri = 0;
 }
 
 
@@ -21,37 +35,25 @@ Fila *fila_cria() {
     assert(f != NULL);
 
     f->n_elem = 0;
-    f->pri = NULL;
+    f->cap = FILA_CAP_INICIAL;
+    f->pri = 0;
+    f->dados = (int*) malloc(f->cap * sizeof(int));
+    assert(f->dados != NULL);
 
     return f;
 }
 
 
 void fila_destroi(Fila *self) {
-    NoFila *p = self->pri;
-    while (p != NULL) {
-        NoFila *temp = p;
-        p = p->prox;
-        free(temp);
-    }
+    free(self->dados);
     free(self);
 }
 
 
 void fila_enque(Fila *self, int dado) {
-    NoFila *novo_no = no_cria(dado);
-
-    if (fila_vazia(self)) {
-        self->pri = novo_no;
-    } else {
-        NoFila *p = self->pri;
-        while (p->prox != NULL)
-        {
-            p = p->prox;
-        }
-        p->prox = novo_no;
-    }
+    if (self->n_elem == self->cap) fila_aumenta(self);
 
+    self->dados[fila_indice(self, self->n_elem)] = dado;
     self->n_elem++;
 }
 
@@ -59,10 +61,8 @@ void fila_enque(Fila *self, int dado) {
 int fila_deque(Fila *self) {
     if (fila_vazia(self)) return -1;
 
-    NoFila *no_removido = self->pri;
-    int dado_removido = no_removido->dado;
-    self->pri = self->pri->prox;
-    free(no_removido);
+    int dado_removido = self->dados[self->pri];
+    self->pri = (self->pri + 1) % self->cap;
 
     self->n_elem--;
     return dado_removido;
@@ -70,14 +70,9 @@ int fila_deque(Fila *self) {
 
 
 int fila_get(Fila *self, int pos) {
-    if (fila_vazia(self)) return -1;
+    if (pos < 0 || pos >= self->n_elem) return -1;
 
-    NoFila *p = self->pri;
-    for (int i = 0; i < pos; i++) {
-        p = p->prox;
-    }
-
-    return p->dado;
+    return self->dados[fila_indice(self, pos)];
 }
 
 
@@ -88,4 +83,4 @@ int fila_n_elem(Fila *self) {
 
 bool fila_vazia(Fila *self) {
     return self->n_elem == 0;
-}
\ No newline at end of file
+}
@@ -5,14 +5,15 @@
 #include <stdbool.h>
 
 
-typedef struct NoFila {
-    int dado;             // dado armazenado no nó
-    struct NoFila *prox;  // ponteiro para o próximo nó
-} NoFila;
-
+// fila de inteiros em um vetor circular
+// inserir no fim, retirar do início e acessar uma posição não dependem do
+//   tamanho da fila, e não alocam memória (o vetor só é realocado, com o dobro
+//   do tamanho, quando fica cheio)
 typedef struct Fila {
-    int n_elem;   // número de processos na fila
-    NoFila *pri;  // ponteiro para o primeiro nó da fila   
+    int n_elem;   // número de elementos na fila
+    int cap;      // número de posições do vetor
+    int pri;      // posição do primeiro elemento no vetor
+    int *dados;   // vetor circular com os elementos
 } Fila;
 
 
@@ -31,4 +32,4 @@ int fila_n_elem(Fila *self);
 bool fila_vazia(Fila *self);
 
 
-#endif
\ No newline at end of file
+#endif
@@ -4,12 +4,8 @@
 ; espera os 3 terminarem e se mata
 ;
 
-; chamadas de sistema (ver so.h)
-SO_LE          define 1
-SO_ESCR        define 2
-SO_CRIA_PROC   define 7
-SO_MATA_PROC   define 8
-SO_ESPERA_PROC define 9
+; chamadas de sistema
+         inclui sistema.asm
 
 limpa    define 10
 
@@ -82,14 +78,10 @@ nao_morri string 'nao morri! '
 
 ; imprime a string que inicia em A (destroi X)
 impstr   espaco 1
-         TRAX
-impstr1
-         CARGX 0
-         DESVZ impstrf
-         CHAMA impch
-         INCX
-         DESV impstr1
-impstrf  RET impstr
+         trax
+         cargi SO_ESCR_STR
+         chamas
+         ret impstr
 
 ; função que chama o SO para imprimir o caractere em A
 ; retorna em A o código de erro do SO
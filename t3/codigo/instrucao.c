@@ -46,6 +46,9 @@ struct {
   { "STRING", 1,  STRING },
   { "ESPACO", 1,  ESPACO },
   { "DEFINE", 1,  DEFINE },
+  { "INCLUI", 1,  INCLUI },
+  { "MACRO",  0,  MACRO  },
+  { "FIMMACRO", 0, FIMMACRO },
 };
 
 opcode_t instrucao_opcode(char *nome)
@@ -17,6 +17,16 @@
 //   DEFINE - define um valor para um símbolo (obrigatoriamente tem que ter
 //            um label, que é definido com o valor do argumento e não com a
 //            posição atual da memória)
+//   INCLUI - monta o conteúdo do arquivo cujo nome é o argumento, como se
+//            estivesse no lugar da linha
+//   MACRO  - inicia a definição de uma macro, com o nome do label e os
+//            parâmetros do argumento (opcional, separados por vírgula); as
+//            linhas seguintes, até FIMMACRO, são o corpo da macro
+//   FIMMACRO - termina a definição de uma macro
+// Uma macro é usada como uma instrução, com os valores dos parâmetros no
+//   argumento, separados por vírgula. As linhas do corpo são montadas no
+//   lugar, trocando "%parâmetro" pelo valor do parâmetro e "%%nome" por um
+//   label local, diferente em cada uso da macro.
 
 typedef enum {
   // instruções normais
@@ -54,6 +64,9 @@ typedef enum {
   STRING,      // inicializa próximas posições de memória
   ESPACO,      // inicializa próximar posições de memória com zeros
   DEFINE,      // define o valor de um símbolo
+  INCLUI,      // inclui um arquivo
+  MACRO,       // inicia a definição de uma macro
+  FIMMACRO,    // termina a definição de uma macro
   N_OPCODE
 } opcode_t;
 
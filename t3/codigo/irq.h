@@ -15,9 +15,9 @@ typedef enum {
   IRQ_SISTEMA,       // chamada de sistema
   // interrupções geradas por dispositivos de E/S
   IRQ_RELOGIO,       // interrupção causada pelo relógio
-  // interrupções de E/S ainda não implementadas
-  IRQ_TECLADO,       // interrupção causada pelo teclado
-  IRQ_TELA,          // interrupção causada pela tela
+  IRQ_TECLADO,       // interrupção causada pelo teclado (tem entrada)
+  IRQ_TELA,          // interrupção causada pela tela (está livre)
+  IRQ_DISCO,         // interrupção causada pelo disco (transferência concluída)
   N_IRQ              // número de interrupções
 } irq_t;
 
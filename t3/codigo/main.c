@@ -9,6 +9,7 @@
 #include "mmu.h"
 #include "cpu.h"
 #include "relogio.h"
+#include "disco.h"
 #include "console.h"
 #include "terminal.h"
 #include "es.h"
@@ -17,9 +18,14 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
 
 // constantes
-#define MEM_TAM 10000        // tamanho da memória principal
+#define MEM_TAM 10000        // tamanho da memória principal e da secundária
+#define TEMPO_DISCO 50       // tempo de transferência de uma página pelo disco
+#define N_PERFIL 20          // endereços mais executados no perfil
 
 // estrutura com os componentes do computador simulado
 typedef struct {
@@ -28,15 +34,18 @@ typedef struct {
   mmu_t *mmu;
   cpu_t *cpu;
   relogio_t *relogio;
+  disco_t *disco;
   console_t *console;
   es_t *es;
   controle_t *controle;
 } hardware_t;
 
 
-// registra no controlador de es os 4 dispositivos do terminal 'id_term'
-//   da console, com valores a partir de n_disp
-static void registra_terminal(hardware_t *hw, int n_disp, char id_term)
+// registra no controlador de es os 5 dispositivos do terminal 'id_term'
+//   da console: os 4 primeiros com valores a partir de n_disp, o das
+//   interrupções com o valor n_disp_int
+static void registra_terminal(hardware_t *hw, int n_disp, int n_disp_int,
+                              char id_term)
 {
   terminal_t *terminal;
   terminal = console_terminal(hw->console, id_term);
@@ -49,6 +58,7 @@ static void registra_terminal(hardware_t *hw, int n_disp, char id_term)
   es_registra_dispositivo(hw->es, n_disp + TERM_TECLADO_OK, terminal, TERM_TECLADO_OK, terminal_leitura, NULL);
   es_registra_dispositivo(hw->es, n_disp + TERM_TELA,       terminal, TERM_TELA,       NULL, terminal_escrita);
   es_registra_dispositivo(hw->es, n_disp + TERM_TELA_OK,    terminal, TERM_TELA_OK,    terminal_leitura, NULL);
+  es_registra_dispositivo(hw->es, n_disp_int,               terminal, TERM_INTERRUPCAO, terminal_leitura, terminal_escrita);
 }
 
 // inicializa a memória ROM com o conteúdo do programa em bios.maq
@@ -81,41 +91,83 @@ static void inicializa_rom(mem_t *mem)
   prog_destroi(prog);
 }
 
-static void cria_hardware(hardware_t *hw)
+// opções da execução, da linha de comando ou de um arquivo de configuração
+typedef struct {
+  // se false, executa em lote, sem a console na tela (ver console_cria_sem_tela)
+  bool com_tela;
+  // nível máximo das mensagens impressas na console (ver console_log)
+  console_nivel_t nivel_log;
+  // escalonador de processos do SO
+  so_escalonador_t escalonador;
+  // instruções entre interrupções do relógio, e interrupções em um quantum
+  int intervalo_relogio;
+  int quantum;
+  // algoritmo de substituição de páginas do SO
+  so_substituicao_t substituicao;
+  // tamanho inicial da tabela de processos do SO
+  int n_processos;
+  // tamanho da memória principal e da secundária, e das páginas
+  int mem_tam;
+  int mem2_tam;
+  int tam_pagina;
+  // tempo de transferência de uma página pelo disco
+  int tempo_disco;
+  // programa do processo inicial
+  char programa_inicial[100];
+  // arquivo onde escrever as estatísticas no final, ou NULL
+  char *arq_metricas;
+  // arquivo onde escrever o perfil de execução no final, ou NULL para não
+  //   fazer o perfil
+  char *arq_perfil;
+  // arquivo onde escrever o estado da CPU antes de cada instrução, ou NULL
+  char *arq_rastro;
+} opcoes_t;
+
+static void cria_hardware(hardware_t *hw, opcoes_t *opc)
 {
   // cria a memória
-  hw->mem = mem_cria(MEM_TAM);
+  hw->mem = mem_cria(opc->mem_tam);
   inicializa_rom(hw->mem);
   // cria a memória secundária
-  hw->mem2 = mem_cria(MEM_TAM);
+  hw->mem2 = mem_cria(opc->mem2_tam);
   // cria a MMU
-  hw->mmu = mmu_cria(hw->mem);
+  hw->mmu = mmu_cria(hw->mem, opc->tam_pagina);
 
   // cria dispositivos de E/S
-  hw->console = console_cria();
+  if (opc->com_tela) {
+    hw->console = console_cria();
+  } else {
+    hw->console = console_cria_sem_tela();
+  }
   hw->relogio = relogio_cria();
+  hw->disco = disco_cria(hw->mem, hw->mem2, opc->tam_pagina, opc->tempo_disco);
 
   // cria o controlador de E/S e registra os dispositivos
   //   por exemplo, o dispositivo 8 do controlador de E/S (e da CPU) será o
   //   dispositivo 0 do relógio (que é o contador de instruções)
   hw->es = es_cria();
-  // registra os 4 dispositivos de cada terminal
-  registra_terminal(hw, D_TERM_A, 'A');
-  registra_terminal(hw, D_TERM_B, 'B');
-  registra_terminal(hw, D_TERM_C, 'C');
-  registra_terminal(hw, D_TERM_D, 'D');
+  // registra os 5 dispositivos de cada terminal
+  registra_terminal(hw, D_TERM_A, D_TERM_A_INTERRUPCAO, 'A');
+  registra_terminal(hw, D_TERM_B, D_TERM_B_INTERRUPCAO, 'B');
+  registra_terminal(hw, D_TERM_C, D_TERM_C_INTERRUPCAO, 'C');
+  registra_terminal(hw, D_TERM_D, D_TERM_D_INTERRUPCAO, 'D');
   // registra os 4 dispositivos do relógio
   es_registra_dispositivo(hw->es, D_RELOGIO_INSTRUCOES, hw->relogio, 0, relogio_leitura, NULL);
   es_registra_dispositivo(hw->es, D_RELOGIO_REAL      , hw->relogio, 1, relogio_leitura, NULL);
   es_registra_dispositivo(hw->es, D_RELOGIO_TIMER     , hw->relogio, 2, relogio_leitura, relogio_escrita);
   es_registra_dispositivo(hw->es, D_RELOGIO_INTERRUPCAO,hw->relogio, 3, relogio_leitura, relogio_escrita);
+  // registra os 4 dispositivos do disco
+  es_registra_dispositivo(hw->es, D_DISCO_QUADRO    , hw->disco, DISCO_QUADRO    , disco_leitura, disco_escrita);
+  es_registra_dispositivo(hw->es, D_DISCO_BLOCO     , hw->disco, DISCO_BLOCO     , disco_leitura, disco_escrita);
+  es_registra_dispositivo(hw->es, D_DISCO_COMANDO   , hw->disco, DISCO_COMANDO   , disco_leitura, disco_escrita);
+  es_registra_dispositivo(hw->es, D_DISCO_CONCLUIDOS, hw->disco, DISCO_CONCLUIDOS, disco_leitura, disco_escrita);
 
   // cria a unidade de execução e inicializa com a MMU e o controlador de E/S
   hw->cpu = cpu_cria(hw->mmu, hw->es);
 
   // cria o controlador da CPU e inicializa com a unidade de execução, a console e
   //   o relógio
-  hw->controle = controle_cria(hw->cpu, hw->console, hw->relogio);
+  hw->controle = controle_cria(hw->cpu, hw->console, hw->relogio, hw->disco);
 }
 
 static void destroi_hardware(hardware_t *hw)
@@ -124,24 +176,317 @@ static void destroi_hardware(hardware_t *hw)
   cpu_destroi(hw->cpu);
   es_destroi(hw->es);
   relogio_destroi(hw->relogio);
+  disco_destroi(hw->disco);
   console_destroi(hw->console);
   mmu_destroi(hw->mmu);
   mem_destroi(hw->mem);
   mem_destroi(hw->mem2);
 }
 
-int main()
+// estatísticas coletadas pelo hardware e pelo SO durante a execução
+typedef struct {
+  long tics;
+  long t_parada;            // tics com a CPU parada
+  long t_parada_com_disco;  // tics com a CPU parada e o disco ocupado
+  long tlb_acertos;
+  long tlb_falhas;
+  long faltas;
+  long substituicoes;
+  long escritas_mem2;
+  long transferencias;
+  long t_disco_ocupado;
+  long processos;
+  long trocas;
+  long preempcoes;
+} metricas_t;
+
+static void coleta_metricas(hardware_t *hw, so_t *so, metricas_t *m)
+{
+  m->tics = relogio_agora();
+  controle_estatisticas(hw->controle, &m->t_parada, &m->t_parada_com_disco);
+  mmu_estatisticas_tlb(hw->mmu, &m->tlb_acertos, &m->tlb_falhas);
+  so_estatisticas_paginacao(so, &m->faltas, &m->substituicoes,
+                            &m->escritas_mem2);
+  disco_estatisticas(hw->disco, &m->transferencias, &m->t_disco_ocupado);
+  so_estatisticas_escalonamento(so, &m->processos, &m->trocas,
+                                &m->preempcoes);
+}
+
+// imprime na console as estatísticas coletadas pelo hardware e pelo SO
+static void imprime_estatisticas(metricas_t *m, so_escalonador_t escalonador,
+                                 so_substituicao_t substituicao)
+{
+  console_printf("MMU: TLB %dx%d, %ld acertos, %ld falhas",
+                 TLB_N_CONJUNTOS, TLB_N_VIAS, m->tlb_acertos, m->tlb_falhas);
+  console_printf("SO: escalonador %s, %ld processos, %ld trocas de processo, "
+                 "%ld preempções", so_nome_escalonador(escalonador),
+                 m->processos, m->trocas, m->preempcoes);
+  console_printf("SO: substituição %s, %ld faltas de página, %ld substituições, "
+                 "%ld escritas em mem2", so_nome_substituicao(substituicao),
+                 m->faltas, m->substituicoes, m->escritas_mem2);
+  console_printf("DISCO: %ld transferências, ocupado em %ld tics, "
+                 "sobrepostos com a CPU em %ld", m->transferencias,
+                 m->t_disco_ocupado, m->t_disco_ocupado - m->t_parada_com_disco);
+  console_printf("CPU: parada em %ld de %ld tics", m->t_parada, m->tics);
+}
+
+// escreve as estatísticas no arquivo 'nome_arq', uma por linha, no formato
+//   'nome valor' (o mesmo do arquivo de configuração), para serem lidas por
+//   outros programas (ver bench.sh)
+static void escreve_metricas(metricas_t *m, char *nome_arq)
+{
+  FILE *arq = fopen(nome_arq, "w");
+  if (arq == NULL) {
+    console_printf("ERRO: não foi possível criar '%s'", nome_arq);
+    return;
+  }
+  fprintf(arq, "tics %ld\n", m->tics);
+  fprintf(arq, "cpu_parada %ld\n", m->t_parada);
+  fprintf(arq, "tlb_acertos %ld\n", m->tlb_acertos);
+  fprintf(arq, "tlb_falhas %ld\n", m->tlb_falhas);
+  fprintf(arq, "processos %ld\n", m->processos);
+  fprintf(arq, "trocas %ld\n", m->trocas);
+  fprintf(arq, "preempcoes %ld\n", m->preempcoes);
+  fprintf(arq, "faltas %ld\n", m->faltas);
+  fprintf(arq, "substituicoes %ld\n", m->substituicoes);
+  fprintf(arq, "escritas_mem2 %ld\n", m->escritas_mem2);
+  fprintf(arq, "transferencias %ld\n", m->transferencias);
+  fprintf(arq, "disco_ocupado %ld\n", m->t_disco_ocupado);
+  fprintf(arq, "disco_sobreposto %ld\n",
+          m->t_disco_ocupado - m->t_parada_com_disco);
+  fclose(arq);
+}
+
+// escreve o relatório do perfil de execução no arquivo 'nome_arq'
+static void escreve_perfil(perfil_t *perfil, char *nome_arq)
+{
+  FILE *arq = fopen(nome_arq, "w");
+  if (arq == NULL) {
+    console_printf("ERRO: não foi possível criar '%s'", nome_arq);
+    return;
+  }
+  perfil_relatorio(perfil, arq, N_PERFIL);
+  fclose(arq);
+}
+
+static void uso(char *nome)
+{
+  fprintf(stderr, "ERRO: chame como '%s [-s] [-l nível] [-m arquivo] [-f arquivo] [-r arquivo]\n"
+          "       [-c arquivo] [-e escalonador] [-i intervalo] [-q quantum] [-p algoritmo] [-d tempo]'\n", nome);
+  fprintf(stderr, "  -s  executa sem tela, com os terminais em arquivos\n");
+  fprintf(stderr, "  -l  nível das mensagens na console (0 a %d, padrão %d)\n",
+          LOG_TRACO, LOG_INFO);
+  fprintf(stderr, "  -m  escreve as estatísticas da execução no arquivo, com linhas 'nome valor'\n");
+  fprintf(stderr, "  -f  conta as instruções executadas e escreve o perfil de execução no arquivo\n");
+  fprintf(stderr, "  -r  escreve o modo e os registradores da CPU antes de cada instrução no arquivo\n");
+  fprintf(stderr, "  -c  lê opções de um arquivo de configuração, com linhas 'nome valor'\n");
+  fprintf(stderr, "      (nomes: as opções abaixo e mem_tam, mem2_tam, tam_pagina,\n");
+  fprintf(stderr, "      n_processos e programa_inicial; padrão %d, %d, %d, %d e init.maq);\n",
+          MEM_TAM, MEM_TAM, TAM_PAGINA, SO_N_PROCESSOS);
+  fprintf(stderr, "      as opções seguintes na linha de comando têm precedência\n");
+  fprintf(stderr, "  -e  escalonador de processos (escalonador):");
+  for (so_escalonador_t alg = 0; alg < N_ESCAL; alg++) {
+    fprintf(stderr, " %s", so_nome_escalonador(alg));
+  }
+  fprintf(stderr, " (padrão %s)\n", so_nome_escalonador(ESCAL_SIMPLES));
+  fprintf(stderr, "  -i  instruções entre interrupções do relógio (intervalo_relogio, pelo menos %d,\n"
+          "      padrão %d)\n", SO_INTERVALO_RELOGIO_MIN, SO_INTERVALO_RELOGIO);
+  fprintf(stderr, "  -q  quantum, em interrupções do relógio (quantum, padrão %d)\n",
+          SO_QUANTUM);
+  fprintf(stderr, "  -p  algoritmo de substituição de páginas (substituicao):");
+  for (so_substituicao_t alg = 0; alg < N_SUBST; alg++) {
+    fprintf(stderr, " %s", so_nome_substituicao(alg));
+  }
+  fprintf(stderr, " (padrão %s)\n", so_nome_substituicao(SUBST_FIFO));
+  fprintf(stderr, "  -d  tempo de transferência de uma página pelo disco (tempo_disco, padrão %d)\n",
+          TEMPO_DISCO);
+  exit(1);
+}
+
+// coloca em '*pvalor' o inteiro em 'texto', que deve ser pelo menos 'min'
+// retorna false se 'texto' não for um inteiro assim
+static bool converte_int(char *texto, int min, int *pvalor)
+{
+  char *fim;
+  long valor = strtol(texto, &fim, 10);
+  if (*texto == '\0' || *fim != '\0' || valor < min || valor > INT_MAX) {
+    return false;
+  }
+  *pvalor = valor;
+  return true;
+}
+
+// define a opção de nome 'nome' com o valor em 'valor'
+// retorna false se não existir opção com esse nome ou se o valor for inválido
+static bool define_opcao(opcoes_t *opc, char *nome, char *valor)
+{
+  if (strcmp(nome, "escalonador") == 0) {
+    for (so_escalonador_t alg = 0; alg < N_ESCAL; alg++) {
+      if (strcmp(valor, so_nome_escalonador(alg)) == 0) {
+        opc->escalonador = alg;
+        return true;
+      }
+    }
+    return false;
+  }
+  if (strcmp(nome, "substituicao") == 0) {
+    for (so_substituicao_t alg = 0; alg < N_SUBST; alg++) {
+      if (strcmp(valor, so_nome_substituicao(alg)) == 0) {
+        opc->substituicao = alg;
+        return true;
+      }
+    }
+    return false;
+  }
+  if (strcmp(nome, "intervalo_relogio") == 0) {
+    if (converte_int(valor, SO_INTERVALO_RELOGIO_MIN, &opc->intervalo_relogio)) {
+      return true;
+    }
+    fprintf(stderr, "ERRO: o intervalo do relógio deve ser pelo menos %d instruções,\n"
+            "      para executar o tratador de interrupção\n", SO_INTERVALO_RELOGIO_MIN);
+    return false;
+  }
+  if (strcmp(nome, "quantum") == 0) return converte_int(valor, 1, &opc->quantum);
+  if (strcmp(nome, "n_processos") == 0) return converte_int(valor, 1, &opc->n_processos);
+  if (strcmp(nome, "mem_tam") == 0) return converte_int(valor, 1, &opc->mem_tam);
+  if (strcmp(nome, "mem2_tam") == 0) return converte_int(valor, 1, &opc->mem2_tam);
+  if (strcmp(nome, "tam_pagina") == 0) return converte_int(valor, 1, &opc->tam_pagina);
+  if (strcmp(nome, "tempo_disco") == 0) return converte_int(valor, 1, &opc->tempo_disco);
+  if (strcmp(nome, "programa_inicial") == 0) {
+    if (strlen(valor) >= sizeof(opc->programa_inicial)) return false;
+    strcpy(opc->programa_inicial, valor);
+    return true;
+  }
+  return false;
+}
+
+// lê opções de um arquivo de configuração, uma por linha, no formato
+//   'nome valor' (ver define_opcao); linhas vazias e o que estiver depois
+//   de um '#' são ignorados
+// termina o programa se o arquivo não puder ser lido ou tiver algum erro
+static void le_configuracao(char *nome_arq, opcoes_t *opc)
+{
+  FILE *arq = fopen(nome_arq, "r");
+  if (arq == NULL) {
+    fprintf(stderr, "ERRO: não foi possível abrir '%s'\n", nome_arq);
+    exit(1);
+  }
+  char linha[200];
+  int n_linha = 0;
+  while (fgets(linha, sizeof(linha), arq) != NULL) {
+    n_linha++;
+    char *comentario = strchr(linha, '#');
+    if (comentario != NULL) *comentario = '\0';
+    char *nome = strtok(linha, " \t\r\n");
+    if (nome == NULL) continue;
+    char *valor = strtok(NULL, " \t\r\n");
+    if (valor == NULL || strtok(NULL, " \t\r\n") != NULL
+        || !define_opcao(opc, nome, valor)) {
+      fprintf(stderr, "ERRO: %s:%d: opção inválida\n", nome_arq, n_linha);
+      exit(1);
+    }
+  }
+  fclose(arq);
+}
+
+static void verifica_args(int argc, char *argv[argc], opcoes_t *opc)
+{
+  opc->com_tela = true;
+  opc->nivel_log = LOG_INFO;
+  opc->escalonador = ESCAL_SIMPLES;
+  opc->intervalo_relogio = SO_INTERVALO_RELOGIO;
+  opc->quantum = SO_QUANTUM;
+  opc->substituicao = SUBST_FIFO;
+  opc->n_processos = SO_N_PROCESSOS;
+  opc->mem_tam = MEM_TAM;
+  opc->mem2_tam = MEM_TAM;
+  opc->tam_pagina = TAM_PAGINA;
+  opc->tempo_disco = TEMPO_DISCO;
+  strcpy(opc->programa_inicial, "init.maq");
+  opc->arq_metricas = NULL;
+  opc->arq_perfil = NULL;
+  opc->arq_rastro = NULL;
+  for (int argi = 1; argi < argc; argi++) {
+    if (strcmp(argv[argi], "-s") == 0) {
+      opc->com_tela = false;
+    } else if (strcmp(argv[argi], "-l") == 0 && argi + 1 < argc) {
+      char *fim;
+      long nivel = strtol(argv[++argi], &fim, 10);
+      if (*fim != '\0' || nivel < LOG_ERRO || nivel > LOG_TRACO) uso(argv[0]);
+      opc->nivel_log = nivel;
+    } else if (strcmp(argv[argi], "-m") == 0 && argi + 1 < argc) {
+      opc->arq_metricas = argv[++argi];
+    } else if (strcmp(argv[argi], "-f") == 0 && argi + 1 < argc) {
+      opc->arq_perfil = argv[++argi];
+    } else if (strcmp(argv[argi], "-r") == 0 && argi + 1 < argc) {
+      opc->arq_rastro = argv[++argi];
+    } else if (strcmp(argv[argi], "-c") == 0 && argi + 1 < argc) {
+      le_configuracao(argv[++argi], opc);
+    } else if (strcmp(argv[argi], "-e") == 0 && argi + 1 < argc) {
+      if (!define_opcao(opc, "escalonador", argv[++argi])) uso(argv[0]);
+    } else if (strcmp(argv[argi], "-i") == 0 && argi + 1 < argc) {
+      if (!define_opcao(opc, "intervalo_relogio", argv[++argi])) uso(argv[0]);
+    } else if (strcmp(argv[argi], "-q") == 0 && argi + 1 < argc) {
+      if (!define_opcao(opc, "quantum", argv[++argi])) uso(argv[0]);
+    } else if (strcmp(argv[argi], "-p") == 0 && argi + 1 < argc) {
+      if (!define_opcao(opc, "substituicao", argv[++argi])) uso(argv[0]);
+    } else if (strcmp(argv[argi], "-d") == 0 && argi + 1 < argc) {
+      if (!define_opcao(opc, "tempo_disco", argv[++argi])) uso(argv[0]);
+    } else {
+      uso(argv[0]);
+    }
+  }
+}
+
+int main(int argc, char *argv[argc])
 {
   hardware_t hw;
   so_t *so;
+  opcoes_t opc;
+
+  verifica_args(argc, argv, &opc);
+  console_define_nivel_log(opc.nivel_log);
 
   // cria o hardware
-  cria_hardware(&hw);
+  cria_hardware(&hw, &opc);
   // cria o sistema operacional
   so = so_cria(hw.cpu, hw.mem, hw.mem2, hw.mmu, hw.es, hw.console);
+  so_define_n_processos(so, opc.n_processos);
+  so_define_escalonador(so, opc.escalonador);
+  so_define_quantum(so, opc.intervalo_relogio, opc.quantum);
+  so_define_substituicao(so, opc.substituicao);
+  so_define_programa_inicial(so, opc.programa_inicial);
+  perfil_t *perfil = NULL;
+  if (opc.arq_perfil != NULL) {
+    perfil = perfil_cria(mem_tam(hw.mem));
+    cpu_define_perfil(hw.cpu, perfil);
+    so_define_perfil(so, perfil);
+  }
+  FILE *rastro = NULL;
+  if (opc.arq_rastro != NULL) {
+    rastro = fopen(opc.arq_rastro, "w");
+    if (rastro == NULL) {
+      fprintf(stderr, "ERRO: não foi possível criar '%s'\n", opc.arq_rastro);
+      exit(1);
+    }
+    cpu_define_rastro(hw.cpu, rastro);
+  }
 
   // executa o laço principal do controlador
-  controle_laco(hw.controle);
+  if (opc.com_tela) {
+    controle_laco(hw.controle);
+  } else {
+    controle_laco_sem_tela(hw.controle);
+  }
+  metricas_t metricas;
+  coleta_metricas(&hw, so, &metricas);
+  imprime_estatisticas(&metricas, opc.escalonador, opc.substituicao);
+  if (opc.arq_metricas != NULL) escreve_metricas(&metricas, opc.arq_metricas);
+  if (perfil != NULL) {
+    escreve_perfil(perfil, opc.arq_perfil);
+    perfil_destroi(perfil);
+  }
+  if (rastro != NULL) fclose(rastro);
 
   // destroi tudo
   so_destroi(so);
@@ -6,12 +6,16 @@
 #include "memoria.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 // tipo de dados para representar uma região de memória
 struct mem_t {
   int tam;
   int *conteudo;
+  // função e argumento para avisar alterações no conteúdo
+  mem_f_alteracao_t f_alteracao;
+  void *arg_alteracao;
 };
 
 
@@ -27,6 +31,8 @@ mem_t *mem_cria(int tam)
   assert(self->conteudo != NULL);
 
   self->tam = tam;
+  self->f_alteracao = NULL;
+  self->arg_alteracao = NULL;
 
   return self;
 }
@@ -55,6 +61,23 @@ static err_t verifica_permissao(mem_t *self, int endereco)
   return ERR_OK;
 }
 
+// função auxiliar, verifica se todos os endereços do bloco são válidos
+static err_t verifica_permissao_bloco(mem_t *self, int endereco, int n)
+{
+  if (n < 0 || endereco < 0 || endereco > self->tam - n) {
+    return ERR_END_INV;
+  }
+  return ERR_OK;
+}
+
+// função auxiliar, avisa a alteração de um bloco
+static void avisa_alteracao(mem_t *self, int endereco, int n)
+{
+  if (self->f_alteracao != NULL && n > 0) {
+    self->f_alteracao(self->arg_alteracao, endereco, n);
+  }
+}
+
 err_t mem_le(mem_t *self, int endereco, int *pvalor)
 {
   err_t err = verifica_permissao(self, endereco);
@@ -69,6 +92,44 @@ err_t mem_escreve(mem_t *self, int endereco, int valor)
   err_t err = verifica_permissao(self, endereco);
   if (err == ERR_OK) {
     self->conteudo[endereco] = valor;
+    avisa_alteracao(self, endereco, 1);
+  }
+  return err;
+}
+
+err_t mem_le_bloco(mem_t *self, int endereco, int n, int valores[n])
+{
+  err_t err = verifica_permissao_bloco(self, endereco, n);
+  if (err == ERR_OK) {
+    memcpy(valores, &self->conteudo[endereco], n * sizeof(*valores));
   }
   return err;
 }
+
+err_t mem_escreve_bloco(mem_t *self, int endereco, int n, const int valores[n])
+{
+  err_t err = verifica_permissao_bloco(self, endereco, n);
+  if (err == ERR_OK) {
+    memcpy(&self->conteudo[endereco], valores, n * sizeof(*valores));
+    avisa_alteracao(self, endereco, n);
+  }
+  return err;
+}
+
+err_t mem_copia(mem_t *dest, int end_dest, mem_t *orig, int end_orig, int n)
+{
+  err_t err = verifica_permissao_bloco(orig, end_orig, n);
+  if (err == ERR_OK) err = verifica_permissao_bloco(dest, end_dest, n);
+  if (err == ERR_OK) {
+    memmove(&dest->conteudo[end_dest], &orig->conteudo[end_orig],
+            n * sizeof(*dest->conteudo));
+    avisa_alteracao(dest, end_dest, n);
+  }
+  return err;
+}
+
+void mem_define_aviso_alteracao(mem_t *self, mem_f_alteracao_t func, void *arg)
+{
+  self->f_alteracao = func;
+  self->arg_alteracao = arg;
+}
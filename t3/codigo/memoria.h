@@ -6,13 +6,17 @@
 
 // A memória é um vetor de inteiros, com um inteiro em cada posição, entre 0
 //   e tam-1 (tam é o tamanho da memória, especificado na criação).
-// Tem só 3 operações:
+// Tem 3 operações principais:
 // - obter o tamanho da memória
 // - obter o valor do inteiro que está em uma das posições
 // - alterar o valor o inteiro que está em uma das posições
+// e as operações em bloco correspondentes, que acessam várias posições
+//   consecutivas de uma vez (usadas para transferir páginas e carregar
+//   programas)
 //
 // O único erro possível no acesso é uma tentativa de acesso a uma posição
-//   inexistente
+//   inexistente; nas operações em bloco, o bloco todo é verificado antes, e
+//   nada é acessado se alguma posição for inexistente
 
 #ifndef MEMORIA_H
 #define MEMORIA_H
@@ -42,4 +46,29 @@ err_t mem_le(mem_t *self, int endereco, int *pvalor);
 // retorna erro ERR_END_INV se endereço inválido
 err_t mem_escreve(mem_t *self, int endereco, int valor);
 
+// copia para 'valores' os 'n' valores a partir do endereço 'endereco'
+// retorna erro ERR_END_INV se algum endereço for inválido
+err_t mem_le_bloco(mem_t *self, int endereco, int n, int valores[n]);
+
+// coloca os 'n' valores de 'valores' a partir do endereço 'endereco'
+// retorna erro ERR_END_INV se algum endereço for inválido
+err_t mem_escreve_bloco(mem_t *self, int endereco, int n, const int valores[n]);
+
+// copia 'n' valores a partir do endereço 'end_orig' da memória 'orig' para
+//   a memória 'dest' a partir do endereço 'end_dest' (as memórias podem ser a
+//   mesma, mesmo com os blocos sobrepostos)
+// retorna erro ERR_END_INV se algum endereço for inválido
+err_t mem_copia(mem_t *dest, int end_dest, mem_t *orig, int end_orig, int n);
+
+// tipo da função chamada quando o conteúdo da memória é alterado
+// recebe o argumento fornecido no registro, o endereço da primeira posição
+//   alterada e o número de posições alteradas
+typedef void (*mem_f_alteracao_t)(void *arg, int endereco, int tam);
+
+// define a função a ser chamada (e o argumento a passar para ela) após
+//   cada alteração bem sucedida do conteúdo da memória
+// se 'func' for NULL, as alterações não são avisadas
+// (usado pela CPU para manter válidas as instruções que ela já decodificou)
+void mem_define_aviso_alteracao(mem_t *self, mem_f_alteracao_t func, void *arg);
+
 #endif // MEMORIA_H
@@ -8,21 +8,54 @@
 #include <stdlib.h>
 #include <assert.h>
 
+// uma entrada da TLB: guarda a tradução de uma página da tabela em uso
+typedef struct {
+  bool valida;
+  int pagina;
+  int quadro;
+  // bits de acesso e alteração da página que já foram marcados na tabela
+  //   de páginas por acessos que passaram por esta entrada
+  bool acessada;
+  bool alterada;
+  // quando foi usada pela última vez (para escolher a entrada a substituir)
+  unsigned long ultimo_uso;
+} tlb_entrada_t;
+
 // tipo de dados opaco para representar uma MMU
 struct mmu_t {
   // memória física
   mem_t *mem;
+  int tam_pagina;
   // tabela de páginas
   tabpag_t *tabpag;
+  // TLB, associativa por conjunto: a página p só pode estar nas entradas
+  //   do conjunto p % n_conjuntos, que são as entradas
+  //   tlb[conj * n_vias] a tlb[conj * n_vias + n_vias - 1]
+  int tlb_n_conjuntos;
+  int tlb_n_vias;
+  tlb_entrada_t *tlb;
+  unsigned long tlb_relogio;
+  // contadores de traduções encontradas ou não na TLB
+  long tlb_acertos;
+  long tlb_falhas;
 };
 
-mmu_t *mmu_cria(mem_t *mem)
+mmu_t *mmu_cria(mem_t *mem, int tam_pagina)
 {
+  assert(tam_pagina > 0);
   mmu_t *self;
   self = malloc(sizeof(*self));
   assert(self != NULL);
   self->mem = mem;
+  self->tam_pagina = tam_pagina;
   self->tabpag = NULL;
+  self->tlb_n_conjuntos = TLB_N_CONJUNTOS;
+  self->tlb_n_vias = TLB_N_VIAS;
+  self->tlb = calloc(TLB_N_CONJUNTOS * TLB_N_VIAS, sizeof(*self->tlb));
+  assert(self->tlb != NULL);
+  self->tlb_relogio = 0;
+  self->tlb_acertos = 0;
+  self->tlb_falhas = 0;
   return self;
 }
 
@@ -30,52 +63,153 @@ void mmu_destroi(mmu_t *self)
 {
   if (self != NULL) {
     // nem a tabela de páginas nem a memória pertencem à MMU, não são destruídas aqui
+    free(self->tlb);
     free(self);
   }
 }
 
+mem_t *mmu_memoria(mmu_t *self)
+{
+  return self->mem;
+}
+
+int mmu_tam_pagina(mmu_t *self)
+{
+  return self->tam_pagina;
+}
+
+// invalida todas as entradas da TLB
+static void mmu__esvazia_tlb(mmu_t *self)
+{
+  int n_entradas = self->tlb_n_conjuntos * self->tlb_n_vias;
+  for (int i = 0; i < n_entradas; i++) {
+    self->tlb[i].valida = false;
+  }
+}
+
 void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag)
 {
   self->tabpag = tabpag;
+  // as traduções da TLB são da tabela anterior
+  mmu__esvazia_tlb(self);
+}
+
+void mmu_invalida_pagina(mmu_t *self, int pagina)
+{
+  if (pagina < 0) return;
+  tlb_entrada_t *conj = &self->tlb[(pagina % self->tlb_n_conjuntos) * self->tlb_n_vias];
+  for (int via = 0; via < self->tlb_n_vias; via++) {
+    if (conj[via].valida && conj[via].pagina == pagina) {
+      conj[via].valida = false;
+    }
+  }
+}
+
+void mmu_estatisticas_tlb(mmu_t *self, long *pacertos, long *pfalhas)
+{
+  *pacertos = self->tlb_acertos;
+  *pfalhas = self->tlb_falhas;
+}
+
+// retorna a entrada da TLB com a tradução da página 'pagina', obtendo a
+//   tradução da tabela de páginas se não estiver na TLB
+// retorna NULL se a página for inválida
+static tlb_entrada_t *mmu__tlb_entrada(mmu_t *self, int pagina)
+{
+  self->tlb_relogio++;
+  tlb_entrada_t *conj = &self->tlb[(pagina % self->tlb_n_conjuntos) * self->tlb_n_vias];
+  tlb_entrada_t *vitima = &conj[0];
+  for (int via = 0; via < self->tlb_n_vias; via++) {
+    tlb_entrada_t *ent = &conj[via];
+    if (ent->valida && ent->pagina == pagina) {
+      self->tlb_acertos++;
+      ent->ultimo_uso = self->tlb_relogio;
+      return ent;
+    }
+    // a vítima é uma entrada livre ou, se não tiver, a usada há mais tempo
+    if (!vitima->valida) continue;
+    if (!ent->valida || ent->ultimo_uso < vitima->ultimo_uso) vitima = ent;
+  }
+  self->tlb_falhas++;
+  int quadro;
+  if (tabpag_traduz(self->tabpag, pagina, &quadro) != ERR_OK) return NULL;
+  vitima->valida = true;
+  vitima->pagina = pagina;
+  vitima->quadro = quadro;
+  vitima->acessada = false;
+  vitima->alterada = false;
+  vitima->ultimo_uso = self->tlb_relogio;
+  return vitima;
 }
 
 // traduz o endereço virtual 'endvirt', colocando o endereço físico
-//   correspondente em 'pendfis'.
+//   correspondente em 'pendfis', e marca a página como acessada (e
+//   alterada, se 'alteracao' for true) na tabela de páginas
 // retorna ERR_OK ou um erro se a tradução não for possível
-static err_t mmu__traduz(mmu_t *self, int endvirt, int *pendfis)
+static err_t mmu__traduz(mmu_t *self, int endvirt, int *pendfis, bool alteracao)
 {
-  int pagina = endvirt / TAM_PAGINA;
-  int deslocamento = endvirt % TAM_PAGINA;
-  int quadro;
-  err_t err = tabpag_traduz(self->tabpag, pagina, &quadro);
-  if (err == ERR_OK) {
-    *pendfis = quadro * TAM_PAGINA + deslocamento;
+  int pagina = endvirt / self->tam_pagina;
+  int deslocamento = endvirt % self->tam_pagina;
+  if (pagina < 0) return ERR_PAG_AUSENTE;
+  tlb_entrada_t *ent = mmu__tlb_entrada(self, pagina);
+  if (ent == NULL) return ERR_PAG_AUSENTE;
+  int endfis = ent->quadro * self->tam_pagina + deslocamento;
+  console_log(LOG_TRACO, "TRADUÇÃO: end_virt %d -> end_fis %d", endvirt, endfis);
+  if (endfis < 0 || endfis >= mem_tam(self->mem)) return ERR_END_INV;
+  // os bits só precisam ser marcados na tabela na primeira vez; depois,
+  //   só se a tabela for alterada, e aí a entrada é invalidada
+  //   (ver mmu_invalida_pagina)
+  if (!ent->acessada || (alteracao && !ent->alterada)) {
+    tabpag_marca_bit_acesso(self->tabpag, pagina, alteracao);
+    ent->acessada = true;
+    if (alteracao) ent->alterada = true;
   }
-  console_printf("TRADUÇÃO: end_virt %d -> end_fis %d", endvirt, pendfis);
-  return err;
+  *pendfis = endfis;
+  return ERR_OK;
+}
+
+err_t mmu_traduz(mmu_t *self, int endvirt, int *pendfis, cpu_modo_t modo)
+{
+  if (modo == supervisor || self->tabpag == NULL) {
+    if (endvirt < 0 || endvirt >= mem_tam(self->mem)) return ERR_END_INV;
+    *pendfis = endvirt;
+    return ERR_OK;
+  }
+  return mmu__traduz(self, endvirt, pendfis, false);
 }
 
 err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
 {
   // em modo supervisor ou se não tiver tabela de páginas,
   //   não faz tradução de endereços, nem marca o acesso
-  //console_printf("mmu_le endvirt=%d", endvirt);
-    if (modo == supervisor || self->tabpag == NULL) {
-  //console_printf("retornando sem traduzir");
-      return mem_le(self->mem, endvirt, pvalor);
-    }
-    int endfis;
-    err_t err = mmu__traduz(self, endvirt, &endfis);
-    if (err == ERR_OK) {
-  console_printf("tradução ok, endfis=%d", endfis);
-      err = mem_le(self->mem, endfis, pvalor);
-      if (err == ERR_OK) {
-        tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, false);
-      }
-  console_printf("erro no acesso à mem");
-    }
-  if (err != ERR_OK) console_printf("erro %d", err);
-    return err;
+  if (modo == supervisor || self->tabpag == NULL) {
+    return mem_le(self->mem, endvirt, pvalor);
+  }
+  int endfis;
+  err_t err = mmu__traduz(self, endvirt, &endfis, false);
+  if (err == ERR_OK) {
+    err = mem_le(self->mem, endfis, pvalor);
+  }
+  if (err != ERR_OK) {
+    console_log(LOG_TRACO, "MMU: erro %d na leitura de %d", err, endvirt);
+  }
+  return err;
+}
+
+err_t mmu_examina(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
+{
+  if (modo == supervisor || self->tabpag == NULL) {
+    return mem_le(self->mem, endvirt, pvalor);
+  }
+  // consulta a tabela diretamente, sem passar pela TLB
+  int pagina = endvirt / self->tam_pagina;
+  int quadro;
+  if (pagina < 0 || tabpag_traduz(self->tabpag, pagina, &quadro) != ERR_OK) {
+    return ERR_PAG_AUSENTE;
+  }
+  int endfis = quadro * self->tam_pagina + endvirt % self->tam_pagina;
+  if (endfis < 0 || endfis >= mem_tam(self->mem)) return ERR_END_INV;
+  return mem_le(self->mem, endfis, pvalor);
 }
 
 err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo)
@@ -86,12 +220,9 @@ err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo)
     return mem_escreve(self->mem, endvirt, valor);
   }
   int endfis;
-  err_t err = mmu__traduz(self, endvirt, &endfis);
+  err_t err = mmu__traduz(self, endvirt, &endfis, true);
   if (err == ERR_OK) {
     err = mem_escreve(self->mem, endfis, valor);
-    if (err == ERR_OK) {
-      tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, true);
-    }
   }
   return err;
 }
@@ -19,25 +19,63 @@ typedef struct mmu_t mmu_t;
 #include "err.h"
 #include "cpu.h"
 
-// tamanho de uma página, em palavras de memória
-// t3: pode ser alterado para comparar configurações diferentes
+// tamanho padrão de uma página, em palavras de memória (ver mmu_cria)
 #define TAM_PAGINA 10
 
+// a MMU tem uma TLB, que guarda as traduções mais recentes da tabela de
+//   páginas em uso, para não precisar consultar a tabela a cada acesso
+// a TLB é associativa por conjunto, com TLB_N_CONJUNTOS conjuntos de
+//   TLB_N_VIAS entradas cada; a página p só pode estar no conjunto
+//   p % TLB_N_CONJUNTOS; dentro do conjunto, é substituída a entrada usada
+//   há mais tempo
+// t3: podem ser alterados para comparar configurações diferentes
+#define TLB_N_CONJUNTOS 8
+#define TLB_N_VIAS      2
+
 // cria uma MMU para gerenciar acessos à memória
 // retorna um ponteiro para um descritor, que deverá ser usado em todas
 //   as operações nessa MMU
-// recebe 'mem', a memória física que será gerenciada
+// recebe 'mem', a memória física que será gerenciada, e o tamanho das
+//   páginas (e dos quadros), em palavras
 // mata o programa em caso de erro (malloc)
-mmu_t *mmu_cria(mem_t *mem);
+mmu_t *mmu_cria(mem_t *mem, int tam_pagina);
 
 // destrói uma MMU
 // nenhuma outra operação pode ser realizada na MMU após esta chamada
 void mmu_destroi(mmu_t *self);
 
+// retorna a memória física gerenciada pela MMU
+mem_t *mmu_memoria(mmu_t *self);
+
+// retorna o tamanho das páginas, em palavras
+int mmu_tam_pagina(mmu_t *self);
+
 // define a tabela de páginas a usar nas próximas traduções
 // se tabpag for NULL, os acessos serão repassados à memória sem alteração
+// esvazia a TLB
 void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag);
 
+// remove da TLB a tradução da página 'pagina' da tabela em uso
+// deve ser chamada sempre que o descritor dessa página for alterado na tabela
+//   em uso (tabpag_define_quadro, tabpag_invalida_pagina,
+//   tabpag_zera_bit_acesso), para que a próxima tradução dessa página
+//   consulte a tabela (e volte a marcar os bits de acesso e alteração)
+void mmu_invalida_pagina(mmu_t *self, int pagina);
+
+// coloca em '*pacertos' e '*pfalhas' o número de traduções que foram
+//   encontradas na TLB e que tiveram que consultar a tabela de páginas
+void mmu_estatisticas_tlb(mmu_t *self, long *pacertos, long *pfalhas);
+
+// coloca na posição apontada por 'pendfis' o endereço físico correspondente
+//   ao endereço virtual 'endvirt', sem acessar a memória
+// marca a página como acessada (mas não alterada) se a tradução for bem
+//   sucedida
+// retorna erro se a tradução não for possível (ver tabpag_traduz) ou se o
+//   endereço físico não existir na memória (ERR_END_INV)
+// em modo supervisor, ou se a mmu não tiver tabela de página definida, o
+//   endereço físico é o próprio 'endvirt'
+err_t mmu_traduz(mmu_t *self, int endvirt, int *pendfis, cpu_modo_t modo);
+
 // coloca na posição apontada por 'pvalor' o valor que está na memória
 //   no endereço físico correspondente ao endereço virtual 'endvirt'
 // marca a página como acessada se o acesso for bem sucedido
@@ -48,6 +86,13 @@ void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag);
 //   à memória sem tradução
 err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo);
 
+// como mmu_le, mas sem efeitos na MMU nem na tabela de páginas: não usa
+//   nem altera a TLB (e suas estatísticas), e não marca a página como
+//   acessada
+// para ler a memória de um processo sem interferir na sua execução (nas
+//   descrições do estado da CPU, por exemplo)
+err_t mmu_examina(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo);
+
 // coloca 'valor' no endereço físico da memória correspondente ao endereço
 //   virtual 'endvirt'
 // marca a página como acessada e alterada se o acesso for bem sucedido
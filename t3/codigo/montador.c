@@ -8,12 +8,14 @@
 // ---------------------------------------------------------------------
 
 #include "instrucao.h"
+#include "programa.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <stdarg.h>
 
 
 // ---------------------------------------------------------------------
@@ -27,6 +29,20 @@ void erro_brabo(char *msg)
   exit(1);
 }
 
+char *arquivo_atual;  // nome do arquivo sendo montado (ver monta_arquivo)
+
+// imprime uma mensagem de erro na linha 'linha' do arquivo sendo montado
+// a mensagem é formatada como no printf
+void erro_linha(int linha, char *fmt, ...)
+{
+  va_list ap;
+  fprintf(stderr, "ERRO: %s: linha %d: ", arquivo_atual, linha);
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  fprintf(stderr, "\n");
+}
+
 // retorna true se tem um número na string s (e retorna o número também)
 bool tem_numero(char *s, int *num)
 {
@@ -41,26 +57,86 @@ bool tem_numero(char *s, int *num)
   return false;
 }
 
+// retorna true se o caractere for um espaço (ou tab)
+bool espaco(char c)
+{
+  return c == ' ' || c == '\t';
+}
+
+// encontra o primeiro caractere espaço (ou tab) na string
+char *pula_ate_espaco(char *s)
+{
+  while (!espaco(*s) && *s != '\0') {
+    s++;
+  }
+  return s;
+}
+
+// troca espaços por fim de string
+char *detona_espacos(char *s)
+{
+  while (espaco(*s)) {
+    *s = '\0';
+    s++;
+  }
+  return s;
+}
+
+char *pula_aspas(char *s)
+{
+  char aspa = *s;
+  s++;
+  while (*s != '\0') {
+    if (*s == aspa) {
+      *s = '\0';
+      s++;
+      break;
+    }
+    s++;
+  }
+  return s;
+}
+
+// faz a string terminar no início de um comentário, se houver
+// aproveita e termina se chegar no fim de linha
+void tira_comentario(char *s)
+{
+  while(*s != '\0' && *s != ';' && *s != '\n' && *s != '\r') {
+    s++;
+  }
+  *s = '\0';
+}
+
 
 // ---------------------------------------------------------------------
 // MEMÓRIA DE SAÍDA {{{1
 // ---------------------------------------------------------------------
 
 // representa a memória do programa -- a saída do montador é colocada aqui
+// o vetor aumenta (dobra de tamanho) quando precisa de mais posições
 
-#define MEM_TAM 10000    // aumentar para programas maiores
-int mem[MEM_TAM];
+int *mem;
+int mem_cap = 0;        // número de posições do vetor
 int mem_pos = 0;        // próxima posição livre da memória
 int mem_min = -1;       // menor endereço preenchido
 int mem_max = -1;       // maior endereço preenchido
 
 char *nome_fonte;   // nome do arquivo fonte a montar
+bool saida_binaria = false;  // gera a saída no formato binário (ver programa.h)
+char *nome_simbolos;         // arquivo onde gravar os labels, ou NULL
 
 // coloca um valor no final da memória
 void mem_insere(int val)
 {
-  if (mem_pos >= MEM_TAM-1) {
-    erro_brabo("programa muito grande! Aumente MEM_TAM no montador.");
+  if (mem_pos < 0) {
+    erro_brabo("endereço negativo na memória do programa");
+  }
+  if (mem_pos >= mem_cap) {
+    int cap = mem_cap == 0 ? 1024 : mem_cap;
+    while (cap <= mem_pos) cap *= 2;
+    mem = realloc(mem, cap * sizeof(int));
+    if (mem == NULL) erro_brabo("sem memória para o programa");
+    mem_cap = cap;
   }
   if (mem_min == -1 || mem_pos < mem_min) mem_min = mem_pos;
   if (mem_max == -1 || mem_pos > mem_max) mem_max = mem_pos;
@@ -76,11 +152,19 @@ void mem_altera(int pos, int val)
   mem[pos] = val;
 }
 
+// retorna o número de posições preenchidas da memória (mem_min e mem_max são
+//   -1 se nada foi montado, por exemplo se o arquivo fonte não foi aberto)
+int mem_tam(void)
+{
+  if (mem_min == -1) return 0;
+  return mem_max - mem_min + 1;
+}
+
 // imprime o conteúdo da memória
 void mem_imprime(void)
 {
-  printf("//MAQ %d %d\n", mem_max - mem_min + 1, mem_min);
-  for (int i = mem_min; i <= mem_max; i+=10) {
+  printf("//MAQ %d %d\n", mem_tam(), mem_min);
+  for (int i = mem_min; i < mem_min + mem_tam(); i+=10) {
     printf("[%4d] =", i);
     for (int j = i; j < i+10 && j <= mem_max; j++) {
       printf(" %d,", mem[j]);
@@ -89,71 +173,159 @@ void mem_imprime(void)
   }
 }
 
+// grava o conteúdo da memória no formato binário
+void mem_grava_binario(void)
+{
+  prog_cabecalho_bin_t cab;
+  memcpy(cab.magico, PROG_MAGICO_BIN, sizeof(cab.magico));
+  cab.tamanho = mem_tam();
+  cab.carga = mem_min;
+  if (fwrite(&cab, sizeof(cab), 1, stdout) != 1) {
+    erro_brabo("erro na escrita da saída");
+  }
+  for (int i = mem_min; i < mem_min + mem_tam(); i++) {
+    int32_t val = mem[i];
+    if (fwrite(&val, sizeof(val), 1, stdout) != 1) {
+      erro_brabo("erro na escrita da saída");
+    }
+  }
+}
+
 
 // ---------------------------------------------------------------------
 // SÍMBOLOS {{{1
 // ---------------------------------------------------------------------
 
 // tabela com os símbolos (labels) já definidos pelo programa, e o valor (endereço) deles
+// os símbolos ficam em um vetor, na ordem em que foram definidos, que aumenta
+//   quando enche; para achar um símbolo pelo nome sem percorrer o vetor, tem
+//   também uma tabela hash com endereçamento aberto com a posição de cada
+//   símbolo no vetor, que tem sempre menos da metade das entradas ocupadas
 
-#define SIMB_TAM 1000
-struct {
+struct simbolo {
   char *nome;
   int valor;
-} simbolo[SIMB_TAM];
+  bool rotulo;    // se é o label de um endereço (não definido com DEFINE)
+} *simbolo;
 int simb_num;             // número d símbolos na tabela
+int simb_cap;             // número de posições do vetor
+int *simb_hash;           // posição do símbolo em 'simbolo', ou -1 se livre
+int simb_hash_cap;        // número de entradas da tabela hash (potência de 2)
+
+// posição inicial da procura de 'nome' na tabela hash (FNV-1a)
+unsigned simb_hash_pos(char *nome)
+{
+  unsigned h = 2166136261u;
+  for (char *c = nome; *c != '\0'; c++) {
+    h = (h ^ (unsigned char)*c) * 16777619u;
+  }
+  return h & (simb_hash_cap - 1);
+}
+
+// retorna a entrada da tabela hash com o símbolo 'nome', ou a entrada livre
+//   onde ele deve ser colocado
+int *simb_hash_acha(char *nome)
+{
+  unsigned i = simb_hash_pos(nome);
+  while (simb_hash[i] != -1 && strcmp(simbolo[simb_hash[i]].nome, nome) != 0) {
+    i = (i + 1) & (simb_hash_cap - 1);
+  }
+  return &simb_hash[i];
+}
+
+// (re)cria a tabela hash com 'cap' entradas, com os símbolos do vetor
+void simb_hash_refaz(int cap)
+{
+  free(simb_hash);
+  simb_hash_cap = cap;
+  simb_hash = malloc(cap * sizeof(int));
+  if (simb_hash == NULL) erro_brabo("sem memória para a tabela de símbolos");
+  memset(simb_hash, -1, cap * sizeof(int));
+  for (int i = 0; i < simb_num; i++) {
+    *simb_hash_acha(simbolo[i].nome) = i;
+  }
+}
 
 // retorna o valor de um símbolo, ou -1 se não existir na tabela
 int simb_valor(char *nome)
 {
-  for (int i=0; i<simb_num; i++) {
-    if (strcmp(nome, simbolo[i].nome) == 0) {
-      return simbolo[i].valor;
-    }
-  }
-  return -1;
+  if (simb_num == 0) return -1;
+  int pos = *simb_hash_acha(nome);
+  if (pos == -1) return -1;
+  return simbolo[pos].valor;
 }
 
 // insere um novo símbolo na tabela
-void simb_novo(char *nome, int valor)
+// 'rotulo' diz se é o label de uma posição do programa
+void simb_novo(char *nome, int valor, bool rotulo)
 {
   if (nome == NULL) return;
   if (simb_valor(nome) != -1) {
-    fprintf(stderr, "ERRO: redefinicao do simbolo '%s'\n", nome);
+    fprintf(stderr, "ERRO: %s: redefinicao do simbolo '%s'\n", arquivo_atual, nome);
     return;
   }
-  if (simb_num >= SIMB_TAM) {
-    erro_brabo("Excesso de símbolos. Aumente SIMB_TAM no montador.");
+  if (simb_num >= simb_cap) {
+    simb_cap = simb_cap == 0 ? 256 : 2 * simb_cap;
+    simbolo = realloc(simbolo, simb_cap * sizeof(struct simbolo));
+    if (simbolo == NULL) erro_brabo("sem memória para a tabela de símbolos");
+  }
+  if (2 * (simb_num + 1) > simb_hash_cap) {
+    simb_hash_refaz(simb_hash_cap == 0 ? 512 : 2 * simb_hash_cap);
   }
   simbolo[simb_num].nome = strdup(nome);
   simbolo[simb_num].valor = valor;
+  simbolo[simb_num].rotulo = rotulo;
+  *simb_hash_acha(nome) = simb_num;
   simb_num++;
 }
 
+// grava no arquivo 'nome' os labels das posições do programa, um por linha,
+//   no formato "endereço nome" (ver simbolos.h)
+// os labels são definidos em ordem crescente de posição, e são gravados nessa
+//   ordem
+void simb_grava(char *nome)
+{
+  FILE *arq = fopen(nome, "w");
+  if (arq == NULL) {
+    fprintf(stderr, "ERRO: não foi possível criar o arquivo '%s'\n", nome);
+    exit(1);
+  }
+  for (int i = 0; i < simb_num; i++) {
+    if (!simbolo[i].rotulo) continue;
+    fprintf(arq, "%d %s\n", simbolo[i].valor, simbolo[i].nome);
+  }
+  fclose(arq);
+}
+
 
 // ---------------------------------------------------------------------
 // REFERÊNCIAS {{{1
 // ---------------------------------------------------------------------
 
 // tabela com referências a símbolos
-//   contém a linha e o endereço onde o símbolo foi referenciado
+//   contém o arquivo, a linha e o endereço onde o símbolo foi referenciado
+// o vetor aumenta (dobra de tamanho) quando enche
 
-#define REF_TAM 1000
-struct {
+struct referencia {
   char *nome;
+  char *arquivo;
   int linha;
   int endereco;
-} ref[REF_TAM];
+} *ref;
 int ref_num;      // numero de referências criadas
+int ref_cap;      // número de posições do vetor
 
 // insere uma nova referência na tabela
 void ref_nova(char *nome, int linha, int endereco)
 {
   if (nome == NULL) return;
-  if (ref_num >= REF_TAM) {
-    erro_brabo("excesso de referências. Aumente REF_TAM no montador.");
+  if (ref_num >= ref_cap) {
+    ref_cap = ref_cap == 0 ? 256 : 2 * ref_cap;
+    ref = realloc(ref, ref_cap * sizeof(struct referencia));
+    if (ref == NULL) erro_brabo("sem memória para as referências");
   }
   ref[ref_num].nome = strdup(nome);
+  ref[ref_num].arquivo = strdup(arquivo_atual);
   ref[ref_num].linha = linha;
   ref[ref_num].endereco = endereco;
   ref_num++;
@@ -166,19 +338,185 @@ void ref_resolve(void)
   for (int i=0; i<ref_num; i++) {
     int valor = simb_valor(ref[i].nome);
     if (valor == -1) {
-      fprintf(stderr, 
-              "ERRO: simbolo '%s' referenciado na linha %d não foi definido\n",
-              ref[i].nome, ref[i].linha);
+      fprintf(stderr,
+              "ERRO: %s: simbolo '%s' referenciado na linha %d não foi definido\n",
+              ref[i].arquivo, ref[i].nome, ref[i].linha);
     }
     mem_altera(ref[i].endereco, valor);
   }
 }
 
 
+// ---------------------------------------------------------------------
+// MACROS {{{1
+// ---------------------------------------------------------------------
+
+// tabela com as macros definidas pelo programa (ver instrucao.h)
+// cada macro tem os nomes dos parâmetros e as linhas do corpo, como estão no
+//   fonte; as substituições são feitas a cada uso (ver macro_usa)
+
+struct macro {
+  char *nome;
+  int n_params;
+  char **params;
+  int n_linhas;
+  int cap_linhas;
+  char **linhas;
+} *macro;
+int macro_num;      // número de macros na tabela
+int macro_cap;      // número de posições do vetor
+struct macro *macro_em_definicao;  // macro cujo corpo está sendo lido, ou NULL
+int macro_usos;     // número de usos de macros, para os labels locais
+
+// separa 'str' nas partes separadas por vírgula, e coloca cópias delas em um
+//   vetor alocado, colocado em *pvet; retorna o número de partes (0 se 'str'
+//   for NULL)
+int separa_virgulas(char *str, char ***pvet)
+{
+  *pvet = NULL;
+  if (str == NULL) return 0;
+  int n = 1;
+  for (char *c = str; *c != '\0'; c++) {
+    if (*c == ',') n++;
+  }
+  char **vet = malloc(n * sizeof(char *));
+  if (vet == NULL) erro_brabo("sem memória para os argumentos");
+  for (int i = 0; i < n; i++) {
+    char *fim = strchr(str, ',');
+    int tam = fim == NULL ? strlen(str) : fim - str;
+    vet[i] = strndup(str, tam);
+    str += tam + 1;
+  }
+  *pvet = vet;
+  return n;
+}
+
+// retorna a macro com o nome 'nome', ou NULL se não existir
+struct macro *macro_acha(char *nome)
+{
+  for (int i = 0; i < macro_num; i++) {
+    if (strcmp(macro[i].nome, nome) == 0) {
+      return &macro[i];
+    }
+  }
+  return NULL;
+}
+
+// inicia a definição da macro 'nome', com os parâmetros em 'params'
+// as próximas linhas, até FIMMACRO, são o corpo (ver macro_le_corpo)
+void macro_nova(int linha, char *nome, char *params)
+{
+  if (nome == NULL) {
+    erro_linha(linha, "'MACRO' exige um label");
+    nome = "";
+  } else if (macro_acha(nome) != NULL || instrucao_opcode(nome) != -1) {
+    erro_linha(linha, "redefinição de '%s'", nome);
+  }
+  if (macro_num >= macro_cap) {
+    macro_cap = macro_cap == 0 ? 16 : 2 * macro_cap;
+    macro = realloc(macro, macro_cap * sizeof(struct macro));
+    if (macro == NULL) erro_brabo("sem memória para as macros");
+  }
+  // o corpo é lido mesmo com erro, para não ser montado como código
+  struct macro *m = &macro[macro_num++];
+  m->nome = strdup(nome);
+  m->n_params = separa_virgulas(params, &m->params);
+  m->n_linhas = 0;
+  m->cap_linhas = 0;
+  m->linhas = NULL;
+  macro_em_definicao = m;
+}
+
+// trata uma linha do corpo da macro em definição: termina a definição se
+//   for FIMMACRO, senão guarda uma cópia da linha no corpo
+void macro_le_corpo(char *str)
+{
+  struct macro *m = macro_em_definicao;
+  // a instrução é a segunda palavra, ou a primeira se começar com espaço
+  char *copia = strdup(str);
+  char *instrucao = copia;
+  tira_comentario(instrucao);
+  if (!espaco(*instrucao)) instrucao = pula_ate_espaco(instrucao);
+  instrucao = detona_espacos(instrucao);
+  *pula_ate_espaco(instrucao) = '\0';
+  bool fim = instrucao_opcode(instrucao) == FIMMACRO;
+  free(copia);
+  if (fim) {
+    macro_em_definicao = NULL;
+    return;
+  }
+  if (m->n_linhas >= m->cap_linhas) {
+    m->cap_linhas = m->cap_linhas == 0 ? 16 : 2 * m->cap_linhas;
+    m->linhas = realloc(m->linhas, m->cap_linhas * sizeof(char *));
+    if (m->linhas == NULL) erro_brabo("sem memória para as macros");
+  }
+  m->linhas[m->n_linhas++] = strdup(str);
+}
+
+// retorna true se 'c' pode fazer parte do nome de um parâmetro ou label local
+bool letra_de_nome(char c)
+{
+  return isalnum(c) || c == '_';
+}
+
+// retorna uma cópia alocada de 'str', uma linha do corpo da macro 'm', com
+//   "%parâmetro" trocado pelo valor correspondente em 'valores' e "%%nome"
+//   trocado por "nome.uso"
+char *macro_substitui(int linha, struct macro *m, char **valores, int uso,
+                      char *str)
+{
+  char *saida;
+  size_t tam;
+  FILE *f = open_memstream(&saida, &tam);
+  if (f == NULL) erro_brabo("sem memória para a expansão de macro");
+  while (*str != '\0') {
+    if (*str != '%') {
+      fputc(*str++, f);
+      continue;
+    }
+    bool local = str[1] == '%';
+    char *nome = str + (local ? 2 : 1);
+    int n = 0;
+    while (letra_de_nome(nome[n])) n++;
+    if (n == 0) {
+      // não é substituição
+      fputc(*str++, f);
+      continue;
+    }
+    if (local) {
+      fprintf(f, "%.*s.%d", n, nome, uso);
+    } else {
+      int p;
+      for (p = 0; p < m->n_params; p++) {
+        if (strlen(m->params[p]) == n && strncmp(m->params[p], nome, n) == 0) {
+          break;
+        }
+      }
+      if (p < m->n_params) {
+        fputs(valores[p], f);
+      } else {
+        erro_linha(linha, "macro '%s' não tem parâmetro '%.*s'", m->nome, n, nome);
+      }
+    }
+    str = nome + n;
+  }
+  fclose(f);
+  return saida;
+}
+
 // ---------------------------------------------------------------------
 // MONTAGEM {{{1
 // ---------------------------------------------------------------------
 
+// profundidade máxima de inclusões e usos de macros, uns dentro dos outros,
+//   para não entrar em recursão infinita
+#define PROFUNDIDADE_MAX 100
+int profundidade = 0;
+
+// usadas na montagem de INCLUI e das macros, estão lá embaixo
+void monta_string(int linha, char *str);
+void monta_arquivo(char *nome);
+
 // realiza a montagem de uma instrução (gera o código para ela na memória),
 //   tendo opcode da instrução e o argumento
 void monta_instrucao(int linha, int opcode, char *arg)
@@ -192,8 +530,7 @@ void monta_instrucao(int linha, int opcode, char *arg)
       argn = simb_valor(arg);
     }
     if (argn < 1) {
-      fprintf(stderr, "ERRO: linha %d 'ESPACO' deve ter valor positivo\n",
-              linha);
+      erro_linha(linha, "'ESPACO' deve ter valor positivo");
       return;
     }
     for (int i = 0; i < argn; i++) {
@@ -230,102 +567,108 @@ void monta_define(int linha, char *label, char *arg)
 {
   int argn;  // para conter o valor numérico do argumento
   if (label == NULL) {
-    fprintf(stderr, "ERRO: linha %d: 'DEFINE' exige um label\n", linha);
+    erro_linha(linha, "'DEFINE' exige um label");
   } else if (!tem_numero(arg, &argn)) {
-    fprintf(stderr, "ERRO: linha %d 'DEFINE' exige valor numérico\n", linha);
+    erro_linha(linha, "'DEFINE' exige valor numérico");
   } else {
     // tudo OK, define o símbolo
-    simb_novo(label, argn);
+    simb_novo(label, argn, false);
   }
 }
 
+// monta uma linha "label INCLUI arquivo", montando o conteúdo do arquivo
+// um nome relativo é relativo ao diretório do arquivo que o inclui
+void monta_inclui(int linha, char *arg)
+{
+  if (arg == NULL) {
+    erro_linha(linha, "'INCLUI' exige um nome de arquivo");
+    return;
+  }
+  if (*arg == '\'' || *arg == '"') arg++;
+  char *dir_fim = strrchr(arquivo_atual, '/');
+  int tam_dir = *arg == '/' || dir_fim == NULL ? 0 : dir_fim - arquivo_atual + 1;
+  char *nome = malloc(tam_dir + strlen(arg) + 1);
+  if (nome == NULL) erro_brabo("sem memória para o nome do arquivo");
+  memcpy(nome, arquivo_atual, tam_dir);
+  strcpy(nome + tam_dir, arg);
+  monta_arquivo(nome);
+  free(nome);
+}
+
+// monta uma linha "label macro valores", com as linhas do corpo da macro
+void macro_usa(int linha, struct macro *m, char *arg)
+{
+  char **valores;
+  int n_valores = separa_virgulas(arg, &valores);
+  if (n_valores != m->n_params) {
+    erro_linha(linha, "macro '%s' exige %d valores, tem %d",
+               m->nome, m->n_params, n_valores);
+  } else if (profundidade >= PROFUNDIDADE_MAX) {
+    erro_linha(linha, "macros aninhadas demais (recursão?)");
+  } else {
+    int uso = ++macro_usos;
+    profundidade++;
+    for (int i = 0; i < m->n_linhas; i++) {
+      char *str = macro_substitui(linha, m, valores, uso, m->linhas[i]);
+      monta_string(linha, str);
+      free(str);
+    }
+    profundidade--;
+  }
+  for (int i = 0; i < n_valores; i++) {
+    free(valores[i]);
+  }
+  free(valores);
+}
+
 // monta uma linha "label instrucao arg"
 void monta_linha(int linha, char *label, char *instrucao, char *arg)
 {
   int opcode = instrucao_opcode(instrucao);
-  // pseudo-instrução DEFINE tem que ser tratada antes, porque não pode
-  //   definir o label de forma normal
+  // pseudo-instruções DEFINE e MACRO têm que ser tratadas antes, porque não
+  //   podem definir o label de forma normal
   if (opcode == DEFINE) {
     monta_define(linha, label, arg);
     return;
   }
+  if (opcode == MACRO) {
+    macro_nova(linha, label, arg);
+    return;
+  }
   
   // cria símbolo correspondente ao label, se for o caso
   if (label != NULL) {
-    simb_novo(label, mem_pos);
+    simb_novo(label, mem_pos, true);
   }
   
   // verifica a existência de instrução e número correto de argumentos
   if (instrucao == NULL) return;
+  if (opcode == -1 && macro_acha(instrucao) != NULL) {
+    macro_usa(linha, macro_acha(instrucao), arg);
+    return;
+  }
   if (opcode == -1) {
-    fprintf(stderr, "ERRO: linha %d: instrucao '%s' desconhecida\n",
-                    linha, instrucao);
+    erro_linha(linha, "instrucao '%s' desconhecida", instrucao);
     return;
   }
   int num_args = instrucao_num_args(opcode);
   if (num_args == 0 && arg != NULL) {
-    fprintf(stderr, "ERRO: linha %d: instrucao '%s' não tem argumento\n",
-                    linha, instrucao);
+    erro_linha(linha, "instrucao '%s' não tem argumento", instrucao);
     return;
   }
   if (num_args == 1 && arg == NULL) {
-    fprintf(stderr, "ERRO: linha %d: instrucao '%s' necessita argumento\n",
-                    linha, instrucao);
+    erro_linha(linha, "instrucao '%s' necessita argumento", instrucao);
     return;
   }
 
   // tudo OK, monta a instrução
-  monta_instrucao(linha, opcode, arg);
-}
-
-// retorna true se o caractere for um espaço (ou tab)
-bool espaco(char c)
-{
-  return c == ' ' || c == '\t';
-}
-
-// encontra o primeiro caractere espaço (ou tab) na string
-char *pula_ate_espaco(char *s)
-{
-  while (!espaco(*s) && *s != '\0') {
-    s++;
-  }
-  return s;
-}
-
-// troca espaços por fim de string
-char *detona_espacos(char *s)
-{
-  while (espaco(*s)) {
-    *s = '\0';
-    s++;
-  }
-  return s;
-}
-
-char *pula_aspas(char *s)
-{
-  char aspa = *s;
-  s++;
-  while (*s != '\0') {
-    if (*s == aspa) {
-      *s = '\0';
-      s++;
-      break;
-    }
-    s++;
-  }
-  return s;
-}
-
-// faz a string terminar no início de um comentário, se houver
-// aproveita e termina se chegar no fim de linha
-void tira_comentario(char *s)
-{
-  while(*s != '\0' && *s != ';' && *s != '\n' && *s != '\r') {
-    s++;
+  if (opcode == INCLUI) {
+    monta_inclui(linha, arg);
+  } else if (opcode == FIMMACRO) {
+    erro_linha(linha, "'FIMMACRO' sem 'MACRO'");
+  } else {
+    monta_instrucao(linha, opcode, arg);
   }
-  *s = '\0';
 }
 
 // uma linha montável é formada por [label][ instrucao[ argumento]]
@@ -336,6 +679,11 @@ void tira_comentario(char *s)
 // quem precisar guardar essas substrings, deve copiá-las.
 void monta_string(int linha, char *str)
 {
+  // as linhas do corpo de uma macro só são montadas quando ela é usada
+  if (macro_em_definicao != NULL) {
+    macro_le_corpo(str);
+    return;
+  }
   char *label = NULL;
   char *instrucao = NULL;
   char *arg = NULL;
@@ -361,7 +709,7 @@ void monta_string(int linha, char *str)
   }
   str = detona_espacos(str);
   if (*str != '\0') {
-    fprintf(stderr, "linha %d: ignorando '%s'\n", linha, str);
+    fprintf(stderr, "%s: linha %d: ignorando '%s'\n", arquivo_atual, linha, str);
   }
   if (label != NULL || instrucao != NULL) {
     monta_linha(linha, label, instrucao, arg);
@@ -371,11 +719,19 @@ void monta_string(int linha, char *str)
 void monta_arquivo(char *nome)
 {
   FILE *arq;
+  if (profundidade >= PROFUNDIDADE_MAX) {
+    fprintf(stderr, "ERRO: inclusões aninhadas demais em '%s' (recursão?)\n",
+            nome);
+    return;
+  }
   arq = fopen(nome, "r");
   if (arq == NULL) {
     fprintf(stderr, "Não foi possível abrir o arquivo '%s'\n", nome);
     return;
   }
+  char *arquivo_anterior = arquivo_atual;
+  arquivo_atual = nome;
+  profundidade++;
   int nlinha = 1;
   char *linha = NULL;
   size_t nbytes;
@@ -385,7 +741,8 @@ void monta_arquivo(char *nome)
   }
   free(linha);
   fclose(arq);
-  ref_resolve();
+  profundidade--;
+  arquivo_atual = arquivo_anterior;
 }
 
 
@@ -408,13 +765,22 @@ void verifica_args(int argc, char *argv[argc])
         fprintf(stderr, "ERRO: endereço inválido: '%s'\n", argv[argi]);
         exit(1);
       }
+    } else if (strcmp(argv[argi], "-b") == 0) {
+      saida_binaria = true;
+    } else if (strcmp(argv[argi], "-s") == 0) {
+      argi++;
+      if (argi >= argc) {
+        fprintf(stderr, "ERRO: falta nome de arquivo após '-s'\n");
+        exit(1);
+      }
+      nome_simbolos = argv[argi];
     } else {
       nome_fonte = argv[argi];
     }
   }
   if (nome_fonte == NULL) {
-    fprintf(stderr, "ERRO: chame como '%s [-e end.inicial] nome_do_arquivo'\n",
-            argv[0]);
+    fprintf(stderr, "ERRO: chame como '%s [-b] [-e end.inicial] [-s arq.sym] "
+                    "nome_do_arquivo'\n", argv[0]);
     exit(1);
   }
 }
@@ -423,7 +789,17 @@ int main(int argc, char *argv[argc])
 {
   verifica_args(argc, argv);
   monta_arquivo(nome_fonte);
-  mem_imprime();
+  if (macro_em_definicao != NULL) {
+    fprintf(stderr, "ERRO: macro '%s' sem 'FIMMACRO'\n",
+            macro_em_definicao->nome);
+  }
+  ref_resolve();
+  if (saida_binaria) {
+    mem_grava_binario();
+  } else {
+    mem_imprime();
+  }
+  if (nome_simbolos != NULL) simb_grava(nome_simbolos);
   return 0;
 }
 
@@ -0,0 +1,306 @@
+// perfil.c
+// contagem das instruções executadas, para achar os trechos mais executados
+// simulador de computador
+// so25b
+
+#include "perfil.h"
+#include "instrucao.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// contagem das execuções de um endereço virtual de um processo
+typedef struct {
+  int pid;
+  int end_virt;
+  long contagem;  // 0 se a entrada estiver livre
+} entrada_t;
+
+// o nome do programa de um processo
+typedef struct {
+  int pid;
+  char *nome;
+  simbolos_t *simbolos;
+} nome_t;
+
+// uma contagem e o que foi contado, para ordenar
+typedef struct {
+  int chave;
+  long contagem;
+} contagem_t;
+
+struct perfil_t {
+  long total;
+  // a última posição conta os códigos de instrução inválidos
+  long por_opcode[N_OPCODE + 1];
+  int tam_mem;
+  long *por_end_fis;
+  // contagens por processo e endereço virtual, em uma tabela hash com
+  //   endereçamento aberto; a capacidade é potência de 2, e dobra quando
+  //   mais da metade das entradas está ocupada
+  entrada_t *entradas;
+  int cap_entradas;
+  int n_entradas;
+  nome_t *nomes;
+  int n_nomes;
+  int cap_nomes;
+  int pid;  // processo em execução
+  simbolos_t *simbolos_so;
+};
+
+perfil_t *perfil_cria(int tam_mem)
+{
+  perfil_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->total = 0;
+  memset(self->por_opcode, 0, sizeof(self->por_opcode));
+  self->tam_mem = tam_mem;
+  self->por_end_fis = calloc(tam_mem, sizeof(long));
+  assert(self->por_end_fis != NULL);
+  self->cap_entradas = 1024;
+  self->entradas = calloc(self->cap_entradas, sizeof(entrada_t));
+  assert(self->entradas != NULL);
+  self->n_entradas = 0;
+  self->cap_nomes = 8;
+  self->nomes = malloc(self->cap_nomes * sizeof(nome_t));
+  assert(self->nomes != NULL);
+  self->n_nomes = 0;
+  self->pid = 0;
+  self->simbolos_so = NULL;
+  return self;
+}
+
+void perfil_destroi(perfil_t *self)
+{
+  for (int i = 0; i < self->n_nomes; i++) {
+    free(self->nomes[i].nome);
+  }
+  free(self->nomes);
+  free(self->entradas);
+  free(self->por_end_fis);
+  free(self);
+}
+
+void perfil_nomeia_processo(perfil_t *self, int pid, char *nome,
+                            simbolos_t *simbolos)
+{
+  if (self->n_nomes == self->cap_nomes) {
+    self->cap_nomes *= 2;
+    self->nomes = realloc(self->nomes, self->cap_nomes * sizeof(nome_t));
+    assert(self->nomes != NULL);
+  }
+  nome_t *n = &self->nomes[self->n_nomes++];
+  n->pid = pid;
+  n->nome = malloc(strlen(nome) + 1);
+  assert(n->nome != NULL);
+  strcpy(n->nome, nome);
+  n->simbolos = simbolos;
+}
+
+void perfil_define_simbolos_so(perfil_t *self, simbolos_t *simbolos)
+{
+  self->simbolos_so = simbolos;
+}
+
+void perfil_define_processo(perfil_t *self, int pid)
+{
+  self->pid = pid;
+}
+
+// posição inicial da procura de (pid, end_virt) na tabela hash
+static int perfil__hash(perfil_t *self, int pid, int end_virt)
+{
+  unsigned h = (unsigned)pid * 0x9e3779b1u ^ (unsigned)end_virt * 0x85ebca6bu;
+  h ^= h >> 16;
+  return h & (self->cap_entradas - 1);
+}
+
+// retorna a entrada de (pid, end_virt) na tabela hash, ou a entrada livre
+//   onde ela deve ser colocada
+static entrada_t *perfil__acha(perfil_t *self, int pid, int end_virt)
+{
+  int i = perfil__hash(self, pid, end_virt);
+  for (;;) {
+    entrada_t *e = &self->entradas[i];
+    if (e->contagem == 0 || (e->pid == pid && e->end_virt == end_virt)) {
+      return e;
+    }
+    i = (i + 1) & (self->cap_entradas - 1);
+  }
+}
+
+// dobra a capacidade da tabela hash, recolocando as entradas
+static void perfil__aumenta(perfil_t *self)
+{
+  entrada_t *velhas = self->entradas;
+  int cap_velha = self->cap_entradas;
+  self->cap_entradas *= 2;
+  self->entradas = calloc(self->cap_entradas, sizeof(entrada_t));
+  assert(self->entradas != NULL);
+  for (int i = 0; i < cap_velha; i++) {
+    if (velhas[i].contagem == 0) continue;
+    *perfil__acha(self, velhas[i].pid, velhas[i].end_virt) = velhas[i];
+  }
+  free(velhas);
+}
+
+void perfil_conta(perfil_t *self, int opcode, int end_fis, int end_virt,
+                  bool usuario)
+{
+  self->total++;
+  if (opcode < 0 || opcode >= N_OPCODE) opcode = N_OPCODE;
+  self->por_opcode[opcode]++;
+  if (end_fis >= 0 && end_fis < self->tam_mem) self->por_end_fis[end_fis]++;
+
+  int pid = usuario ? self->pid : 0;
+  entrada_t *e = perfil__acha(self, pid, end_virt);
+  if (e->contagem == 0) {
+    e->pid = pid;
+    e->end_virt = end_virt;
+    self->n_entradas++;
+  }
+  e->contagem++;
+  if (2 * self->n_entradas > self->cap_entradas) perfil__aumenta(self);
+}
+
+
+// ---------------------------------------------------------------------
+// RELATÓRIO {{{1
+// ---------------------------------------------------------------------
+
+// ordena pela contagem, decrescente, e depois pela chave
+static int perfil__compara(const void *a, const void *b)
+{
+  const contagem_t *ca = a, *cb = b;
+  if (ca->contagem != cb->contagem) return ca->contagem < cb->contagem ? 1 : -1;
+  return (ca->chave > cb->chave) - (ca->chave < cb->chave);
+}
+
+// ordena as entradas da tabela hash pela contagem, decrescente, e depois
+//   por pid e endereço
+static int perfil__compara_entradas(const void *a, const void *b)
+{
+  const entrada_t *ea = a, *eb = b;
+  if (ea->contagem != eb->contagem) return ea->contagem < eb->contagem ? 1 : -1;
+  if (ea->pid != eb->pid) return ea->pid < eb->pid ? -1 : 1;
+  return (ea->end_virt > eb->end_virt) - (ea->end_virt < eb->end_virt);
+}
+
+static char *perfil__nome(perfil_t *self, int pid)
+{
+  if (pid == 0) return "SO";
+  for (int i = 0; i < self->n_nomes; i++) {
+    if (self->nomes[i].pid == pid) return self->nomes[i].nome;
+  }
+  return "?";
+}
+
+static simbolos_t *perfil__simbolos(perfil_t *self, int pid)
+{
+  if (pid == 0) return self->simbolos_so;
+  for (int i = 0; i < self->n_nomes; i++) {
+    if (self->nomes[i].pid == pid) return self->nomes[i].simbolos;
+  }
+  return NULL;
+}
+
+static double perfil__pct(perfil_t *self, long contagem)
+{
+  return 100.0 * contagem / self->total;
+}
+
+static void perfil__relatorio_opcodes(perfil_t *self, FILE *arq)
+{
+  contagem_t cont[N_OPCODE + 1];
+  int n = 0;
+  for (int op = 0; op <= N_OPCODE; op++) {
+    if (self->por_opcode[op] == 0) continue;
+    cont[n++] = (contagem_t){ op, self->por_opcode[op] };
+  }
+  qsort(cont, n, sizeof(contagem_t), perfil__compara);
+  fprintf(arq, "por instrução:\n");
+  for (int i = 0; i < n; i++) {
+    char *nome = cont[i].chave == N_OPCODE ? "inválida"
+                                            : instrucao_nome(cont[i].chave);
+    fprintf(arq, "  %-10s %10ld %6.2f%%\n", nome, cont[i].contagem,
+            perfil__pct(self, cont[i].contagem));
+  }
+}
+
+static void perfil__relatorio_processos(perfil_t *self, FILE *arq)
+{
+  // o SO e os processos nomeados, na ordem em que foram nomeados
+  int n = self->n_nomes + 1;
+  contagem_t *cont = malloc(n * sizeof(contagem_t));
+  assert(cont != NULL);
+  cont[0] = (contagem_t){ 0, 0 };
+  for (int i = 0; i < self->n_nomes; i++) {
+    cont[i + 1] = (contagem_t){ self->nomes[i].pid, 0 };
+  }
+  for (int i = 0; i < self->cap_entradas; i++) {
+    entrada_t *e = &self->entradas[i];
+    if (e->contagem == 0) continue;
+    int p = 0;
+    while (p < n && cont[p].chave != e->pid) p++;
+    if (p < n) cont[p].contagem += e->contagem;
+  }
+  qsort(cont, n, sizeof(contagem_t), perfil__compara);
+  fprintf(arq, "por processo:\n");
+  for (int i = 0; i < n; i++) {
+    if (cont[i].contagem == 0) continue;
+    fprintf(arq, "  [%d] %-12s %10ld %6.2f%%\n", cont[i].chave,
+            perfil__nome(self, cont[i].chave), cont[i].contagem,
+            perfil__pct(self, cont[i].contagem));
+  }
+  free(cont);
+}
+
+static void perfil__relatorio_end_fis(perfil_t *self, FILE *arq, int n_max)
+{
+  contagem_t *cont = malloc(self->tam_mem * sizeof(contagem_t));
+  assert(cont != NULL);
+  int n = 0;
+  for (int end = 0; end < self->tam_mem; end++) {
+    if (self->por_end_fis[end] == 0) continue;
+    cont[n++] = (contagem_t){ end, self->por_end_fis[end] };
+  }
+  qsort(cont, n, sizeof(contagem_t), perfil__compara);
+  fprintf(arq, "endereços físicos mais executados:\n");
+  for (int i = 0; i < n && i < n_max; i++) {
+    fprintf(arq, "  %6d %10ld %6.2f%%\n", cont[i].chave, cont[i].contagem,
+            perfil__pct(self, cont[i].contagem));
+  }
+  free(cont);
+}
+
+static void perfil__relatorio_end_virt(perfil_t *self, FILE *arq, int n_max)
+{
+  entrada_t *ent = malloc(self->n_entradas * sizeof(entrada_t));
+  assert(ent != NULL || self->n_entradas == 0);
+  int n = 0;
+  for (int i = 0; i < self->cap_entradas; i++) {
+    if (self->entradas[i].contagem != 0) ent[n++] = self->entradas[i];
+  }
+  qsort(ent, n, sizeof(entrada_t), perfil__compara_entradas);
+  fprintf(arq, "endereços virtuais mais executados, por processo:\n");
+  for (int i = 0; i < n && i < n_max; i++) {
+    char simbolo[40];
+    simbolos_descreve(perfil__simbolos(self, ent[i].pid), ent[i].end_virt,
+                      simbolo, sizeof(simbolo));
+    fprintf(arq, "  [%d] %-12s %6d %-20s %10ld %6.2f%%\n", ent[i].pid,
+            perfil__nome(self, ent[i].pid), ent[i].end_virt, simbolo,
+            ent[i].contagem, perfil__pct(self, ent[i].contagem));
+  }
+  free(ent);
+}
+
+void perfil_relatorio(perfil_t *self, FILE *arq, int n)
+{
+  fprintf(arq, "PERFIL: %ld instruções executadas\n", self->total);
+  if (self->total == 0) return;
+  perfil__relatorio_opcodes(self, arq);
+  perfil__relatorio_processos(self, arq);
+  perfil__relatorio_end_fis(self, arq, n);
+  perfil__relatorio_end_virt(self, arq, n);
+}
@@ -0,0 +1,56 @@
+// perfil.h
+// contagem das instruções executadas, para achar os trechos mais executados
+// simulador de computador
+// so25b
+
+#ifndef PERFIL_H
+#define PERFIL_H
+
+// conta as instruções executadas pela CPU por código de instrução, por
+//   endereço físico e por processo e endereço virtual, e faz um relatório
+//   com os mais executados
+// as instruções executadas em modo supervisor são atribuídas ao SO (pid 0),
+//   as em modo usuário ao processo definido por perfil_define_processo
+
+#include "simbolos.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// tipo opaco que representa um perfil de execução
+typedef struct perfil_t perfil_t;
+
+// cria um perfil vazio, para uma memória física com 'tam_mem' posições
+// mata o programa em caso de erro (malloc)
+perfil_t *perfil_cria(int tam_mem);
+
+// destrói um perfil
+void perfil_destroi(perfil_t *self);
+
+// associa o nome do programa ao processo 'pid', e a tabela com os labels do
+//   programa (ou NULL), para o relatório
+// a tabela deve existir até o relatório ser feito
+void perfil_nomeia_processo(perfil_t *self, int pid, char *nome,
+                            simbolos_t *simbolos);
+
+// define a tabela com os labels dos programas executados em modo supervisor
+//   (ou NULL, o padrão), para o relatório
+// a tabela deve existir até o relatório ser feito
+void perfil_define_simbolos_so(perfil_t *self, simbolos_t *simbolos);
+
+// define o processo em execução, a quem são atribuídas as próximas
+//   instruções executadas em modo usuário
+void perfil_define_processo(perfil_t *self, int pid);
+
+// conta a execução de uma instrução com o código 'opcode', no endereço
+//   físico 'end_fis' e virtual 'end_virt'; 'usuario' diz se ela foi
+//   executada em modo usuário
+void perfil_conta(perfil_t *self, int opcode, int end_fis, int end_virt,
+                  bool usuario);
+
+// escreve em 'arq' as contagens por código de instrução e por processo, e os
+//   'n' endereços mais executados, físicos e virtuais de cada processo (estes
+//   também como "label+deslocamento", com os labels do programa)
+void perfil_relatorio(perfil_t *self, FILE *arq, int n);
+
+#endif // PERFIL_H
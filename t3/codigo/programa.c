@@ -7,11 +7,22 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// os valores do formato binário são usados diretamente como int
+_Static_assert(sizeof(int) == sizeof(int32_t), "int deve ter 32 bits");
 
 struct programa_t {
   int carga;
   int tamanho;
   int *dados;
+  // se o programa veio de um arquivo binário, os dados estão no mapeamento
+  //   do arquivo, e não foram alocados
+  void *mapa;
+  size_t tam_mapa;
 };
 
 // lê os dados do cabeçalho do arquivo (1ª linha)
@@ -29,6 +40,8 @@ static programa_t *pega_cabecalho(char *lin)
   }
   prog->tamanho = tam;
   prog->carga = carga;
+  prog->mapa = NULL;
+  prog->tam_mapa = 0;
   return prog;
 }
 
@@ -50,12 +63,58 @@ static void pega_dados(programa_t *self, char *lin)
   }
 }
 
+// mapeia na memória um arquivo no formato binário, aberto em 'fd'
+// retorna NULL se o arquivo não estiver nesse formato ou em caso de erro
+static programa_t *mapeia_binario(int fd)
+{
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(prog_cabecalho_bin_t)) {
+    return NULL;
+  }
+  void *mapa = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapa == MAP_FAILED) return NULL;
+  prog_cabecalho_bin_t *cab = mapa;
+  if (memcmp(cab->magico, PROG_MAGICO_BIN, sizeof(cab->magico)) != 0
+      || cab->tamanho < 0
+      || (size_t)st.st_size != sizeof(*cab) + (size_t)cab->tamanho * sizeof(int32_t)) {
+    munmap(mapa, st.st_size);
+    return NULL;
+  }
+  programa_t *prog = malloc(sizeof(*prog));
+  if (prog == NULL) {
+    munmap(mapa, st.st_size);
+    return NULL;
+  }
+  prog->tamanho = cab->tamanho;
+  prog->carga = cab->carga;
+  prog->dados = (int *)(cab + 1);
+  prog->mapa = mapa;
+  prog->tam_mapa = st.st_size;
+  return prog;
+}
+
+// retorna true se o arquivo começa com a identificação do formato binário
+static bool eh_binario(FILE *arq)
+{
+  char magico[sizeof(PROG_MAGICO_BIN) - 1];
+  bool binario = fread(magico, sizeof(magico), 1, arq) == 1
+                 && memcmp(magico, PROG_MAGICO_BIN, sizeof(magico)) == 0;
+  rewind(arq);
+  return binario;
+}
+
 programa_t *prog_cria(char *nome)
 {
   programa_t *prog = NULL;
   FILE *arq = fopen(nome, "r");
   if (arq == NULL) return NULL;
 
+  if (eh_binario(arq)) {
+    prog = mapeia_binario(fileno(arq));
+    fclose(arq);
+    return prog;
+  }
+
   char *linha = NULL;
   size_t tam_lin;
   if (getline(&linha, &tam_lin, arq) == -1) goto fim;
@@ -75,7 +134,11 @@ fim:
 
 void prog_destroi(programa_t *self)
 {
-  free(self->dados);
+  if (self->mapa != NULL) {
+    munmap(self->mapa, self->tam_mapa);
+  } else {
+    free(self->dados);
+  }
   free(self);
 }
 
@@ -99,3 +162,8 @@ int prog_dado(programa_t *self, int ender)
   if (ender < self->carga || ender >= self->carga + self->tamanho) return -1;
   return self->dados[ender - self->carga];
 }
+
+const int *prog_dados(programa_t *self)
+{
+  return self->dados;
+}
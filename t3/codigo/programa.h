@@ -7,6 +7,25 @@
 #define PROGRAMA_H
 
 // TAD para representar um programa lido de um arquivo '.maq'
+//
+// O arquivo pode estar em um de dois formatos, reconhecido pelo conteúdo:
+// - texto: uma linha "//MAQ tamanho carga" seguida de linhas "[end] = v, v, ..."
+// - binário (gerado pelo montador com a opção -b): um cabeçalho
+//   prog_cabecalho_bin_t seguido dos 'tamanho' valores, como inteiros de 32
+//   bits na ordem de bytes da máquina; o arquivo é mapeado na memória e os
+//   valores são usados diretamente, sem conversão
+
+#include <stdint.h>
+
+// identificação do formato binário, no início do arquivo
+#define PROG_MAGICO_BIN "MAQB"
+
+// cabeçalho do formato binário
+typedef struct {
+  char magico[4];   // PROG_MAGICO_BIN, sem o '\0'
+  int32_t tamanho;  // número de valores que seguem o cabeçalho
+  int32_t carga;    // endereço de carga
+} prog_cabecalho_bin_t;
 
 typedef struct programa_t programa_t;
 
@@ -31,4 +50,9 @@ int prog_end_inicio(programa_t *self);
 // valor a colocar na posição 'ender' da memória
 int prog_dado(programa_t *self, int ender);
 
+// vetor com os prog_tamanho() valores a colocar na memória, a partir do
+//   endereço prog_end_carga()
+// o vetor pertence ao programa, e deixa de existir com ele
+const int *prog_dados(programa_t *self);
+
 #endif // PROGRAMA_H
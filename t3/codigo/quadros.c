@@ -0,0 +1,161 @@
+// quadros.c
+// alocador de quadros de memória
+// simulador de computador
+// so25b
+
+#include "quadros.h"
+#include <stdlib.h>
+#include <assert.h>
+
+struct quadros_t {
+  int n_quadros;
+  int n_livres;
+  // para cada quadro, o dono e os vizinhos (-1 se não tiver) na lista em que
+  //   ele está
+  int *dono;
+  int *prox;
+  int *ant;
+  // primeiro quadro da lista de cada dono, indexado por dono + 1 (a posição 0
+  //   é a lista de quadros livres); -1 se a lista estiver vazia
+  int n_listas;
+  int *primeiro;
+};
+
+quadros_t *quadros_cria(int n_quadros)
+{
+  quadros_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->n_quadros = n_quadros;
+  self->n_livres = n_quadros;
+  self->dono = malloc(n_quadros * sizeof(int));
+  self->prox = malloc(n_quadros * sizeof(int));
+  self->ant = malloc(n_quadros * sizeof(int));
+  assert(self->dono != NULL && self->prox != NULL && self->ant != NULL);
+  // todos os quadros começam na lista de livres, em ordem
+  for (int q = 0; q < n_quadros; q++) {
+    self->dono[q] = QUADRO_LIVRE;
+    self->prox[q] = q + 1 < n_quadros ? q + 1 : -1;
+    self->ant[q] = q - 1;
+  }
+  self->n_listas = 1;
+  self->primeiro = malloc(sizeof(int));
+  assert(self->primeiro != NULL);
+  self->primeiro[0] = n_quadros > 0 ? 0 : -1;
+  return self;
+}
+
+void quadros_destroi(quadros_t *self)
+{
+  free(self->dono);
+  free(self->prox);
+  free(self->ant);
+  free(self->primeiro);
+  free(self);
+}
+
+int quadros_n_quadros(quadros_t *self)
+{
+  return self->n_quadros;
+}
+
+int quadros_n_livres(quadros_t *self)
+{
+  return self->n_livres;
+}
+
+// retorna o ponteiro para o início da lista do dono, aumentando o vetor de
+//   listas se necessário
+static int *quadros__lista(quadros_t *self, int dono)
+{
+  assert(dono >= QUADRO_LIVRE);
+  int ind = dono + 1;
+  if (ind >= self->n_listas) {
+    int n_listas = self->n_listas;
+    while (n_listas <= ind) n_listas *= 2;
+    self->primeiro = realloc(self->primeiro, n_listas * sizeof(int));
+    assert(self->primeiro != NULL);
+    for (int i = self->n_listas; i < n_listas; i++) self->primeiro[i] = -1;
+    self->n_listas = n_listas;
+  }
+  return &self->primeiro[ind];
+}
+
+// tira o quadro da lista em que ele está
+static void quadros__retira(quadros_t *self, int quadro)
+{
+  int prox = self->prox[quadro];
+  int ant = self->ant[quadro];
+  if (ant == -1) {
+    *quadros__lista(self, self->dono[quadro]) = prox;
+  } else {
+    self->prox[ant] = prox;
+  }
+  if (prox != -1) self->ant[prox] = ant;
+  if (self->dono[quadro] == QUADRO_LIVRE) self->n_livres--;
+}
+
+// coloca o quadro no início da lista do dono
+static void quadros__insere(quadros_t *self, int quadro, int dono)
+{
+  int *lista = quadros__lista(self, dono);
+  self->dono[quadro] = dono;
+  self->ant[quadro] = -1;
+  self->prox[quadro] = *lista;
+  if (*lista != -1) self->ant[*lista] = quadro;
+  *lista = quadro;
+  if (dono == QUADRO_LIVRE) self->n_livres++;
+}
+
+int quadros_aloca(quadros_t *self, int dono)
+{
+  int quadro = self->primeiro[0];
+  if (quadro == -1) return -1;
+  quadros__retira(self, quadro);
+  quadros__insere(self, quadro, dono);
+  return quadro;
+}
+
+bool quadros_reserva(quadros_t *self, int quadro, int dono)
+{
+  if (quadro < 0 || quadro >= self->n_quadros) return false;
+  if (self->dono[quadro] != QUADRO_LIVRE) return false;
+  quadros__retira(self, quadro);
+  quadros__insere(self, quadro, dono);
+  return true;
+}
+
+void quadros_libera(quadros_t *self, int quadro)
+{
+  if (self->dono[quadro] == QUADRO_LIVRE) return;
+  quadros__retira(self, quadro);
+  quadros__insere(self, quadro, QUADRO_LIVRE);
+}
+
+void quadros_libera_do_dono(quadros_t *self, int dono)
+{
+  if (dono == QUADRO_LIVRE || dono + 1 >= self->n_listas) return;
+  int quadro = self->primeiro[dono + 1];
+  while (quadro != -1) {
+    int prox = self->prox[quadro];
+    quadros__insere(self, quadro, QUADRO_LIVRE);
+    quadro = prox;
+  }
+  self->primeiro[dono + 1] = -1;
+}
+
+int quadros_dono(quadros_t *self, int quadro)
+{
+  if (quadro < 0 || quadro >= self->n_quadros) return QUADRO_LIVRE;
+  return self->dono[quadro];
+}
+
+int quadros_primeiro_do_dono(quadros_t *self, int dono)
+{
+  if (dono + 1 >= self->n_listas) return -1;
+  return self->primeiro[dono + 1];
+}
+
+int quadros_proximo(quadros_t *self, int quadro)
+{
+  return self->prox[quadro];
+}
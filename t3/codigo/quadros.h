@@ -0,0 +1,62 @@
+// quadros.h
+// alocador de quadros de memória
+// simulador de computador
+// so25b
+
+#ifndef QUADROS_H
+#define QUADROS_H
+
+// controla quais quadros de uma memória estão livres e qual o dono de cada
+//   quadro ocupado
+// cada quadro está em uma lista duplamente encadeada: a dos quadros livres ou
+//   a do seu dono; com isso, alocar, reservar e liberar um quadro não depende
+//   do tamanho da memória, e os quadros de um dono podem ser percorridos ou
+//   liberados sem percorrer a memória toda
+// os donos são identificados por inteiros não negativos (o pid, por exemplo)
+
+#include <stdbool.h>
+
+// dono dos quadros livres
+#define QUADRO_LIVRE -1
+
+// tipo opaco que representa o alocador
+typedef struct quadros_t quadros_t;
+
+// cria um alocador para uma memória com 'n_quadros' quadros, todos livres
+// mata o programa em caso de erro (malloc)
+quadros_t *quadros_cria(int n_quadros);
+
+// destrói um alocador
+void quadros_destroi(quadros_t *self);
+
+// retorna o número total de quadros
+int quadros_n_quadros(quadros_t *self);
+
+// retorna o número de quadros livres
+int quadros_n_livres(quadros_t *self);
+
+// aloca um quadro livre qualquer para o dono
+// retorna o número do quadro, ou -1 se não houver quadro livre
+int quadros_aloca(quadros_t *self, int dono);
+
+// aloca o quadro 'quadro' para o dono
+// retorna false (e não faz nada) se o quadro não estiver livre
+bool quadros_reserva(quadros_t *self, int quadro, int dono);
+
+// libera um quadro (não faz nada se ele já estiver livre)
+void quadros_libera(quadros_t *self, int quadro);
+
+// libera todos os quadros do dono
+void quadros_libera_do_dono(quadros_t *self, int dono);
+
+// retorna o dono do quadro, ou QUADRO_LIVRE
+int quadros_dono(quadros_t *self, int quadro);
+
+// percorre os quadros de um dono:
+//   for (q = quadros_primeiro_do_dono(a, d); q != -1; q = quadros_proximo(a, q))
+// o quadro corrente pode ser liberado durante o percurso se o próximo for
+//   obtido antes
+int quadros_primeiro_do_dono(quadros_t *self, int dono);
+int quadros_proximo(quadros_t *self, int quadro);
+
+#endif // QUADROS_H
@@ -29,6 +29,8 @@ relogio_t *relogio_cria(void)
   assert(self != NULL);
 
   self->agora = 0;
+  self->t_ate_interrupcao = 0;
+  self->interrupcao_ativa = false;
 
   return self;
 }
@@ -51,6 +53,20 @@ void relogio_tictac(relogio_t *self)
   }
 }
 
+void relogio_avanca(relogio_t *self, int n)
+{
+  self->agora += n;
+  agora_global = self->agora;
+  if (self->t_ate_interrupcao != 0) {
+    if (self->t_ate_interrupcao <= n) {
+      self->t_ate_interrupcao = 0;
+      self->interrupcao_ativa = true;
+    } else {
+      self->t_ate_interrupcao -= n;
+    }
+  }
+}
+
 err_t relogio_leitura(void *disp, int id, int *pvalor)
 {
   relogio_t *self = disp;
@@ -0,0 +1,125 @@
+; rotinas.asm
+; rotinas de impressão no terminal, para incluir nos programas com
+; 'inclui rotinas.asm' (fora do caminho de execução, porque gera código)
+; usa as chamadas de sistema de sistema.asm
+
+; imprime a string que inicia em A (destroi X)
+impstr   espaco 1
+         trax
+         cargi SO_ESCR_STR
+         chamas
+         ret impstr
+
+; função que chama o SO para imprimir o caractere em A
+; retorna em A o código de erro do SO
+; não altera o valor de X
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1 ; para salvar o valor de X
+
+; escreve o valor de A no terminal, em decimal
+; os dígitos são colocados em ei_buf e escritos com uma só chamada ao SO
+; não altera o valor de X
+impnum  espaco 1
+        ; ei_num = A
+        armm ei_num
+        ; ei_ind = 0
+        cargi 0
+        armm ei_ind
+        cargm ei_num
+        ; if ei_num > 0 goto ei_pos
+        desvp ei_pos
+        ; if ei_num < 0 goto ei_neg
+        desvn ei_neg
+        ; put '0'; goto ei_f
+        cargi '0'
+        chama ei_poe
+        desv ei_f
+ei_neg
+        ; ei_num = -ei_num
+        neg
+        armm ei_num
+        ; put '-'
+        cargi '-'
+        chama ei_poe
+ei_pos
+        ; faz ei_mul ser a maior potência de 10 <= ei_num
+        ; ei_mul = 1
+        cargi 1
+        armm ei_mul
+ei_1
+        ; if ei_mul == ei_num goto ei_3
+        cargm ei_mul
+        sub ei_num
+        desvz ei_3
+        ; if ei_mul > ei_num goto ei_2
+        desvp ei_2
+        ; ei_mul *= 10
+        cargm ei_mul
+        mult dez
+        armm ei_mul
+        ; goto ei_1
+        desv ei_1
+ei_2
+        ; ei_mul /= 10
+        cargm ei_mul
+        div dez
+        armm ei_mul
+ei_3
+        ; put (ei_num/ei_mul) % 10 + '0'
+        cargm ei_num
+        div ei_mul
+        resto dez
+        soma a_zero
+        chama ei_poe
+        ; ei_mul /= 10
+        cargm ei_mul
+        div dez
+        armm ei_mul
+        ; if ei_mul > 0 goto ei_3
+        desvp ei_3
+ei_f
+        ; put ' '; put 0
+        cargi ' '
+        chama ei_poe
+        cargi 0
+        chama ei_poe
+        ; print ei_buf, preservando X
+        trax
+        armm ei_X
+        cargi ei_buf
+        trax
+        cargi SO_ESCR_STR
+        chamas
+        cargm ei_X
+        trax
+        ; return
+        ret impnum
+
+; põe o caractere em A em ei_buf[ei_ind++] (não altera X)
+ei_poe  espaco 1
+        trax
+        armm ei_X
+        cargm ei_ind
+        trax
+        armx ei_buf
+        incx
+        cpxa
+        armm ei_ind
+        cargm ei_X
+        trax
+        ret ei_poe
+ei_num  espaco 1
+ei_mul  espaco 1
+ei_ind  espaco 1
+ei_X    espaco 1
+ei_buf  espaco 16
+a_zero  valor '0'
+dez     valor 10
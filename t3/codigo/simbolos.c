@@ -0,0 +1,144 @@
+// simbolos.c
+// nomes (labels) dos endereços de programas, para as descrições e relatórios
+// simulador de computador
+// so25b
+
+#include "simbolos.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+typedef struct {
+  int endereco;
+  char *nome;
+  int ordem;  // posição em que foi inserido na tabela
+} simbolo_t;
+
+struct simbolos_t {
+  // em ordem de endereço, para a busca binária
+  simbolo_t *simbolos;
+  int n_simbolos;
+  int cap;
+};
+
+simbolos_t *simbolos_cria(void)
+{
+  simbolos_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->n_simbolos = 0;
+  self->cap = 16;
+  self->simbolos = malloc(self->cap * sizeof(simbolo_t));
+  assert(self->simbolos != NULL);
+  return self;
+}
+
+void simbolos_destroi(simbolos_t *self)
+{
+  for (int i = 0; i < self->n_simbolos; i++) {
+    free(self->simbolos[i].nome);
+  }
+  free(self->simbolos);
+  free(self);
+}
+
+static void simbolos__insere(simbolos_t *self, int endereco, char *nome)
+{
+  if (self->n_simbolos == self->cap) {
+    self->cap *= 2;
+    self->simbolos = realloc(self->simbolos, self->cap * sizeof(simbolo_t));
+    assert(self->simbolos != NULL);
+  }
+  simbolo_t *s = &self->simbolos[self->n_simbolos++];
+  s->endereco = endereco;
+  s->ordem = self->n_simbolos - 1;
+  s->nome = malloc(strlen(nome) + 1);
+  assert(s->nome != NULL);
+  strcpy(s->nome, nome);
+}
+
+// ordena por endereço; com endereços iguais, mantém a ordem de inserção
+//   (o primeiro label definido para um endereço é o usado nas descrições)
+static int simbolos__compara(const void *a, const void *b)
+{
+  const simbolo_t *sa = a, *sb = b;
+  if (sa->endereco != sb->endereco) return sa->endereco < sb->endereco ? -1 : 1;
+  return sa->ordem - sb->ordem;
+}
+
+// retorna o nome do arquivo de símbolos do programa 'nome_maq' (alocado, quem
+//   chama deve liberar): troca a extensão '.maq' por '.sym', ou acrescenta
+//   '.sym' se não tiver essa extensão
+static char *simbolos__nome_arquivo(char *nome_maq)
+{
+  size_t tam = strlen(nome_maq);
+  char *nome_sym = malloc(tam + sizeof(".sym"));
+  assert(nome_sym != NULL);
+  strcpy(nome_sym, nome_maq);
+  if (tam >= 4 && strcmp(nome_sym + tam - 4, ".maq") == 0) tam -= 4;
+  strcpy(nome_sym + tam, ".sym");
+  return nome_sym;
+}
+
+bool simbolos_le(simbolos_t *self, char *nome_maq)
+{
+  char *nome_sym = simbolos__nome_arquivo(nome_maq);
+  FILE *arq = fopen(nome_sym, "r");
+  free(nome_sym);
+  if (arq == NULL) return false;
+
+  char *linha = NULL;
+  size_t tam_lin;
+  while (getline(&linha, &tam_lin, arq) != -1) {
+    int endereco, ini = -1, fim = -1;
+    sscanf(linha, "%d %n%*s%n", &endereco, &ini, &fim);
+    if (fim <= ini) continue;  // linha sem endereço ou sem nome
+    linha[fim] = '\0';
+    simbolos__insere(self, endereco, linha + ini);
+  }
+  free(linha);
+  fclose(arq);
+
+  // os labels de cada arquivo já estão em ordem, mas a tabela pode ter
+  //   vários arquivos
+  qsort(self->simbolos, self->n_simbolos, sizeof(simbolo_t), simbolos__compara);
+  return true;
+}
+
+char *simbolos_nome(simbolos_t *self, int endereco, int *pdesloc)
+{
+  // procura o primeiro símbolo com endereço maior que 'endereco'; o anterior
+  //   a ele é o procurado
+  int ini = 0, fim = self->n_simbolos;
+  while (ini < fim) {
+    int meio = (ini + fim) / 2;
+    if (self->simbolos[meio].endereco <= endereco) {
+      ini = meio + 1;
+    } else {
+      fim = meio;
+    }
+  }
+  if (ini == 0) return NULL;
+  // o primeiro dos que têm o mesmo endereço
+  int i = ini - 1;
+  while (i > 0 && self->simbolos[i - 1].endereco == self->simbolos[i].endereco) {
+    i--;
+  }
+  *pdesloc = endereco - self->simbolos[i].endereco;
+  return self->simbolos[i].nome;
+}
+
+void simbolos_descreve(simbolos_t *self, int endereco, char *str, int tam)
+{
+  char *nome = NULL;
+  int desloc;
+  if (self != NULL) nome = simbolos_nome(self, endereco, &desloc);
+  if (nome == NULL) {
+    snprintf(str, tam, "%d", endereco);
+  } else if (desloc == 0) {
+    snprintf(str, tam, "%s", nome);
+  } else {
+    snprintf(str, tam, "%s+%d", nome, desloc);
+  }
+}
@@ -0,0 +1,45 @@
+// simbolos.h
+// nomes (labels) dos endereços de programas, para as descrições e relatórios
+// simulador de computador
+// so25b
+
+#ifndef SIMBOLOS_H
+#define SIMBOLOS_H
+
+// O montador, com a opção -s, gera junto com cada '.maq' um arquivo '.sym'
+//   com os labels do programa que correspondem a endereços (não os definidos
+//   com DEFINE), um por linha, no formato "endereço nome", em ordem de
+//   endereço.
+// Uma tabela de símbolos contém os labels de um ou mais desses arquivos, e
+//   permite descrever um endereço como "label+deslocamento", a partir do
+//   label de maior endereço que não seja maior que ele.
+
+#include <stdbool.h>
+
+// tipo opaco que representa uma tabela de símbolos
+typedef struct simbolos_t simbolos_t;
+
+// cria uma tabela de símbolos vazia
+// mata o programa em caso de erro (malloc)
+simbolos_t *simbolos_cria(void);
+
+// destrói uma tabela de símbolos
+void simbolos_destroi(simbolos_t *self);
+
+// acrescenta à tabela os símbolos do programa no arquivo 'nome_maq' (lidos do
+//   arquivo com o mesmo nome e extensão '.sym')
+// retorna false se não foi possível ler o arquivo (a tabela não é alterada)
+bool simbolos_le(simbolos_t *self, char *nome_maq);
+
+// retorna o nome do label de maior endereço que não é maior que 'endereco',
+//   e coloca em '*pdesloc' a distância entre os dois
+// retorna NULL se não houver um label assim
+// o nome pertence à tabela, e deixa de existir com ela
+char *simbolos_nome(simbolos_t *self, int endereco, int *pdesloc);
+
+// coloca em 'str' (com capacidade para 'tam' caracteres, incluindo o '\0')
+//   a descrição de 'endereco' como "label" ou "label+deslocamento"
+// se não houver label para o endereço, ou 'self' for NULL, coloca o número
+void simbolos_descreve(simbolos_t *self, int endereco, char *str, int tam);
+
+#endif // SIMBOLOS_H
@@ -0,0 +1,11 @@
+; sistema.asm
+; números das chamadas de sistema (ver so.h), para incluir nos programas
+; com 'inclui sistema.asm'; só tem definições, não gera código
+
+SO_LE          define 1
+SO_ESCR        define 2
+SO_CRIA_PROC   define 7
+SO_MATA_PROC   define 8
+SO_ESPERA_PROC define 9
+SO_DORME       define 10
+SO_ESCR_STR    define 11
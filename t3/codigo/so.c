@@ -16,7 +16,9 @@
 #include "programa.h"
 #include "tabpag.h"
 #include "fila.h"
-#include "relogio.h"
+#include "quadros.h"
+#include "alarmes.h"
+#include "simbolos.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -28,20 +30,26 @@
 // CONSTANTES E TIPOS {{{1
 // ---------------------------------------------------------------------
 
-// intervalo entre interrupções do relógio
-#define INTERVALO_INTERRUPCAO 50   // em instruções executadas
-#define QUANTUM 10
+// escalonador de filas com realimentação (MLFQ): cada nível tem uma fila de
+//   prontos e um quantum; o processo que gasta o quantum do seu nível desce
+//   um nível, e de tempos em tempos todos voltam ao primeiro nível
+#define N_NIVEIS_MLFQ 3
+#define QUANTUM_MLFQ { 2, 4, 8 }   // por nível, em interrupções do relógio
+#define PERIODO_ELEVACAO_MLFQ 50   // em interrupções do relógio
 
-#define N_PROCESSOS 5   // número máximo de processos
 #define SEM_PROCESSO -1  // indica que não tem um processo corrente
-
-#define SEM_DISPOSITIVO -1;  // indica que não tem um dispositivo que causou bloqueio
+// o pid de um processo é 1 + índice na tabela + geração * PID_MAX_INDICE; a
+//   geração de uma posição da tabela muda cada vez que ela é reaproveitada,
+//   e o pid de um processo que já morreu não é confundido com o de um novo
+#define PID_MAX_INDICE 0x10000  // número máximo de posições na tabela
+// o maior pid, (PID_MAX_GERACAO + 1) * PID_MAX_INDICE, tem que caber em um int
+//   (no máximo 0x7fffffff), senão a conta do pid estoura
+#define PID_MAX_GERACAO 0x7ffe
+
+#define SEM_DISPOSITIVO -1  // indica que não tem um dispositivo que causou bloqueio
 #define N_TERMINAIS 4
-
-#define ESCALONADOR 0
-#define SEM_ESCALONADOR 0
-#define ROUND_ROBIN 1
-#define PRIORIDADE 2
+#define N_DISP_TERMINAL (D_TERM_B - D_TERM_A)  // dispositivos de cada terminal
+#define TAM_SAIDA_TERMINAL 128  // caracteres na saída de um terminal no SO
 
 // Não tem processos nem memória virtual, mas é preciso usar a paginação,
 //   pelo menos para implementar relocação, já que os programas estão sendo
@@ -68,10 +76,14 @@
 //#define NENHUM_PROCESSO -1
 //#define ALGUM_PROCESSO 0
 
-#define MEM_TAM 10000
-// tempo de transferência de uma página entre a memória principal e a secundária
-#define TEMPO_SWAP 0  // 0 por enquanto para testar
-#define PROTEGIDO 100 // pid de uma página protegida
+// donos dos quadros das memórias principal e secundária: os processos são
+//   identificados pelo índice na tabela (que não muda enquanto ele existe),
+//   depois dos donos que não são processos (ver so_dono)
+#define PROTEGIDO 0        // dono de uma página protegida
+#define BLOCO_PENDENTE 1   // dono de um bloco do disco à espera de escrita
+                           //   pedida por um processo que já morreu
+#define BLOCO_IMAGEM 2     // dono dos blocos do disco das imagens de programas
+#define N_DONOS_ESPECIAIS 3
 
 
 enum estado_t {
@@ -84,14 +96,74 @@ enum estado_t {
 typedef enum estado_t estado_t;
 
 
+// informações sobre um quadro da memória principal usadas na substituição
+//   de páginas (o dono do quadro é mantido pelo alocador de quadros)
 typedef struct quadro {
-  int pid;
   int pagina;
+  unsigned long carga;  // ordem de carga da página no quadro (FIFO e segunda chance)
+  // os quadros com páginas de processos ficam em uma lista na ordem de carga,
+  //   encadeada por estes campos (ver so_registra_carga)
+  bool na_ordem_de_carga;
+  int ant_carga;
+  int prox_carga;
+  unsigned char idade;  // contador de envelhecimento da página (LRU aproximado)
+  bool em_transferencia;  // a página está sendo trazida pelo disco
+  bool nova;              // a página chegou e o dono ainda não progrediu
 } quadro_t;
 
 
+// um pedido de transferência de página feito ao disco
+typedef struct {
+  int comando;  // DISCO_LE ou DISCO_ESCREVE
+  int pid;      // dono da página (SEM_PROCESSO se o dono já morreu)
+  int pagina;
+  int quadro;   // quadro da memória principal
+  int bloco;    // quadro da memória secundária
+} pedido_disco_t;
+
+
+// a imagem de um programa na memória secundária, carregada uma vez e
+//   compartilhada pelos processos que executam o programa
+typedef struct imagem_t {
+  char *nome;      // nome do executável
+  int n_paginas;
+  int *blocos;     // bloco da memória secundária de cada página
+  int n_refs;      // número de processos usando a imagem
+  struct imagem_t *prox;
+} imagem_t;
+
+// os labels de um programa (ver simbolos.h), lidos na primeira vez que um
+//   processo o executa e mantidos até o fim do SO, porque o perfil de
+//   execução os usa depois que os processos morrem
+typedef struct simbolos_programa_t {
+  char *nome;      // nome do executável
+  simbolos_t *simbolos;
+  struct simbolos_programa_t *prox;
+} simbolos_programa_t;
+
+
+// fila de processos, encadeada pelos próprios descritores (ver processo_t)
+// inserir no fim, retirar do início e retirar um processo qualquer não
+//   dependem do tamanho da fila; um processo está em no máximo uma fila (a de
+//   prontos do seu nível ou a de espera de um dispositivo)
+typedef struct fila_proc_t {
+  processo_t *prim;
+  processo_t *ult;
+} fila_proc_t;
+
+// os caracteres escritos em um terminal e ainda não enviados para a tela, em
+//   um vetor circular de tamanho fixo
+typedef struct {
+  int car[TAM_SAIDA_TERMINAL];
+  int prim;  // posição do primeiro caractere no vetor
+  int n;     // número de caracteres
+} saida_terminal_t;
+
+
 struct processo_t {
   int pid;
+  int indice;   // posição na tabela de processos
+  int geracao;  // número de reusos da posição na tabela (ver PID_MAX_INDICE)
   int regPC;
   int regA;
   int regX;
@@ -104,13 +176,28 @@ struct processo_t {
 
   int dispositivo_causou_bloqueio;
   int pid_esperando;  // pid do processo que está esperando morrer
-
-  int quantum;
+  // lista dos processos esperando a morte deste, encadeada por prox_esperando
+  processo_t *esperando;
+  processo_t *prox_esperando;
+  // a fila em que o processo está (NULL se nenhuma), e os vizinhos nela
+  fila_proc_t *fila;
+  processo_t *ant_fila;
+  processo_t *prox_fila;
+  // posição no heap de prontos do escalonador por prioridade, ou -1
+  int pos_prioridade;
+
+  int quantum;     // interrupções do relógio que ainda pode executar
   float prioridade;
+  int nivel;       // nível no MLFQ (0 é o mais alto; nos outros, sempre 0)
+  int epoca_mlfq;  // valor de so->epoca_mlfq quando nivel e quantum mudaram
 
   tabpag_t *tabpag;
-  int quadro_mem2;  // quadro a partir do qual o programa foi carregado em memória secundária
-  int data_desbloqueio;  // data até desbloquear um processo
+  int n_paginas;     // número de páginas do programa
+  int *quadros_mem2; // quadro da memória secundária onde está cada página
+  imagem_t *imagem;  // imagem do programa (as páginas não alteradas estão nela)
+  simbolos_t *simbolos;  // labels do programa, para as descrições de endereços
+  int pc_falta;      // PC da instrução que causou a última falta de página
+  int data_desbloqueio;  // data em que um processo dormindo deve acordar (0 se não dorme)
 };
 
 
@@ -124,29 +211,89 @@ struct so_t {
 
   int regA, regX, regPC, regERRO, regComplemento; // cópia do estado da CPU
   // t2: tabela de processos, processo corrente, pendências, etc
-  processo_t *tabela_de_processos;
+  // a tabela é um vetor de ponteiros para os descritores, que aumenta quando
+  //   fica cheio; os descritores não mudam de lugar, e são reaproveitados
+  processo_t **tabela_de_processos;
+  int cap_tabela;
+  Fila *indices_livres;  // posições livres da tabela
   int n_processos_tabela;
   processo_t *processo_corrente;  // se pid == SEM_PROCESSO, não tem processo
-  Fila *processos_prontos;
+  processo_t sem_processo;        // descritor usado quando não tem processo
+  // os processos no estado PRONTO, na ordem em que devem executar, uma
+  //   fila por nível do MLFQ (os outros escalonadores só usam a primeira)
+  fila_proc_t processos_prontos[N_NIVEIS_MLFQ];
+  // no escalonador por prioridade, os processos no estado PRONTO ficam em um
+  //   heap em vez das filas (ver prioridade_insere)
+  processo_t **prontos_prioridade;
+  int n_prontos_prioridade;
+  int cap_prontos_prioridade;
+  // para cada dispositivo, os processos bloqueados esperando que ele fique
+  //   pronto, na ordem em que pediram a E/S (ver so_trata_pendencias)
+  fila_proc_t espera_dispositivo[N_DISPOSITIVOS];
+  // as interrupções habilitadas em cada terminal (TERM_INT_TECLADO etc)
+  int interrupcoes_terminal[N_TERMINAIS];
+  // os caracteres escritos pelos processos em cada terminal e ainda não
+  //   enviados para a tela; os processos esperando espaço nela estão na fila
+  //   do dispositivo de estado da tela
+  saida_terminal_t saida_terminal[N_TERMINAIS];
+  // os alarmes dos processos dormindo, com o pid de cada um
+  alarmes_t *alarmes;
 
   // vetor com os pids dos processos que estão usando cada terminal (0 == TERM_A, 1 == TERM_B...)
   int terminais_usados[4];
 
-  // primeiro quadro da memória principal que está livre (quadros anteriores estão ocupados)
-  // t3: com memória virtual, o controle de memória livre e ocupada deve ser mais
-  //     completo que isso
-  int quadro_livre_mem;
-  // vetor de quadros com o pid do dono do quadro e o número da página que o ocupa
+  // tamanho das páginas e dos quadros (o da MMU)
+  int tam_pagina;
+  // quadros livres e ocupados da memória principal (o dono é o pid)
+  quadros_t *quadros_mem;
+  // vetor de quadros com o número da página que ocupa cada quadro
   quadro_t *tabquadros;
 
   // -=-=-=-=-=-=-=- Memória secundária -=-=-=-=-=-=-=-
   mem_t *mem2;
-  // indica se a memória secundária está liberada
-  bool mem2_livre;
-  // tempo até liberar a memória secundária
-  int mem2_tempo_ate_livre;
-  // primeiro quadro da memória secundária que está livre
-  int quadro_livre_mem2;
+  // pedidos feitos ao disco e ainda não concluídos, na ordem em que foram
+  //   feitos, que é a ordem em que o disco os atende (fila circular)
+  pedido_disco_t *pedidos_disco;
+  int cap_pedidos_disco;
+  int n_pedidos_disco;
+  int prim_pedido_disco;
+  // quadros livres e ocupados da memória secundária (o dono é o pid)
+  quadros_t *quadros_mem2;
+  // imagens de programas já carregadas na memória secundária
+  imagem_t *imagens;
+
+  // -=-=-=-=-=-=-=- Escalonamento -=-=-=-=-=-=-=-
+  so_escalonador_t escalonador;
+  int intervalo_relogio;  // instruções entre interrupções do relógio
+  int quantum;            // interrupções do relógio (menos no MLFQ)
+  int quantum_mlfq[N_NIVEIS_MLFQ];
+  // interrupções do relógio até a próxima elevação de todos ao nível 0
+  int t_elevacao_mlfq;
+  int epoca_mlfq;  // número de elevações já feitas
+  // programa do processo criado na inicialização
+  char *programa_inicial;
+  // perfil de execução, informado dos processos criados e executados
+  perfil_t *perfil;
+  // labels dos programas executados em modo supervisor (a bios e o
+  //   tratador de interrupção), e dos programas dos processos
+  simbolos_t *simbolos_so;
+  simbolos_programa_t *simbolos_programas;
+  // estatísticas
+  long n_processos_criados;
+  long n_trocas;      // vezes que o processo em execução mudou
+  long n_preempcoes;  // vezes que um processo foi tirado de execução sem bloquear
+
+  // -=-=-=-=-=-=-=- Substituição de páginas -=-=-=-=-=-=-=-
+  so_substituicao_t substituicao;
+  // número de páginas já carregadas, para ordenar as cargas nos quadros
+  unsigned long n_cargas;
+  // primeiro e último quadro da lista na ordem de carga, ou -1
+  int prim_carga;
+  int ult_carga;
+  // estatísticas
+  long n_faltas;
+  long n_substituicoes;
+  long n_escritas_mem2;
 };
 
 
@@ -159,49 +306,197 @@ static int so_trata_interrupcao(void *argC, int reg_A);
 // retorna o endereço virtual inicial de execução
 static int so_carrega_programa(so_t *self, processo_t *processo,
                                char *nome_do_executavel);
+// libera as imagens de programas que não estão sendo usadas por nenhum
+//   processo; retorna true se alguma foi liberada
+static bool so_libera_imagens_sem_uso(so_t *self);
+// retorna a tabela com os labels do programa (vazia se não houver o .sym)
+static simbolos_t *so_simbolos_do_programa(so_t *self, char *nome_do_executavel);
+// copia valores da memória do processo até copiar um 0 (ver a definição)
+static int so_copia_ate_zero_do_processo(so_t *self, processo_t *proc,
+                                         int end_virt, int tam, int valores[tam]);
 // copia para str da memória do processo, até copiar um 0 (retorna true) ou tam bytes
 static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
                                      int end_virt, processo_t processo);
 // imprime a tabela de processos
 static void tablea_proc_imprime(so_t *self)
 {
-  for (int i = 0; i < N_PROCESSOS; i++)
+  // só percorre a tabela se for imprimir
+  if (LOG_DEPURA > LOG_NIVEL_MAX || LOG_DEPURA > console_nivel_log) return;
+  for (int i = 0; i < self->cap_tabela; i++)
   {
-    int pid = self->tabela_de_processos[i].pid;
-    int regA = self->tabela_de_processos[i].regA;
-    int regX = self->tabela_de_processos[i].regX;
-    //int regPC = self->tabela_de_processos[i].regPC;
-    char *exe = self->tabela_de_processos[i].executavel;
-    int estado = self->tabela_de_processos[i].estado;
-    int terminal = self->tabela_de_processos[i].terminal;
-    console_printf("pid: %d || regA: %d || regX: %d || EXE: %s || t: %d || estado: %d", pid, regA, regX, exe, terminal, estado);
+    if (self->tabela_de_processos[i] == NULL) continue;
+    int pid = self->tabela_de_processos[i]->pid;
+    int regA = self->tabela_de_processos[i]->regA;
+    int regX = self->tabela_de_processos[i]->regX;
+    //int regPC = self->tabela_de_processos[i]->regPC;
+    char *exe = self->tabela_de_processos[i]->executavel;
+    int estado = self->tabela_de_processos[i]->estado;
+    int terminal = self->tabela_de_processos[i]->terminal;
+    console_log(LOG_DEPURA, "pid: %d || regA: %d || regX: %d || EXE: %s || t: %d || estado: %d", pid, regA, regX, exe, terminal, estado);
   }
 }
 
 
-// acha o índice de um processo na tabela de processos a partir de seu pid
-static int acha_indice_por_pid(so_t *self, int pid)
+// acha um processo na tabela de processos a partir de seu pid
+// retorna NULL se não existir processo com esse pid
+static processo_t *acha_processo_por_pid(so_t *self, int pid)
 {
-  for (int i = 0; i < N_PROCESSOS; i++)
-  {
-    if (self->tabela_de_processos[i].pid == pid) return i;
-  }
-  return SEM_PROCESSO;
+  if (pid <= 0) return NULL;
+  int indice = (pid - 1) % PID_MAX_INDICE;
+  if (indice >= self->cap_tabela) return NULL;
+  processo_t *proc = self->tabela_de_processos[indice];
+  if (proc == NULL || proc->pid != pid) return NULL;
+  return proc;
 }
 
 
-// retorna o índice do primeiro quadro livre que encontrar na memória principal (-1 se não achar)
-int acha_quadro_livre(so_t *self)
+// dono dos quadros de memória do processo
+static int so_dono(processo_t *proc)
 {
-  for (int i = 0; i < MEM_TAM/TAM_PAGINA; i++)
-  {
-    if (self->tabquadros[i].pid == SEM_PROCESSO)
-    {
-      //console_printf("QUADRO ENCONTRADO: %d", i);
-      return i;
+  return proc->indice + N_DONOS_ESPECIAIS;
+}
+
+
+// processo dono de quadros de memória, ou NULL se o dono não for um processo
+static processo_t *so_processo_do_dono(so_t *self, int dono)
+{
+  int indice = dono - N_DONOS_ESPECIAIS;
+  if (indice < 0 || indice >= self->cap_tabela) return NULL;
+  processo_t *proc = self->tabela_de_processos[indice];
+  if (proc == NULL || proc->pid == SEM_PROCESSO) return NULL;
+  return proc;
+}
+
+
+// libera os quadros das memórias principal e secundária ocupados por um processo
+static void so_libera_memoria_do_processo(so_t *self, processo_t *proc);
+
+// habilita as interrupções do terminal do dispositivo que têm processos esperando
+static void so_atualiza_interrupcoes(so_t *self, int dispositivo);
+
+
+// ---------------------------------------------------------------------
+// Filas de processos
+// ---------------------------------------------------------------------
+
+static bool fila_proc_vazia(fila_proc_t *fila)
+{
+  return fila->prim == NULL;
+}
+
+// insere o processo no fim da fila; ele não pode estar em outra fila
+static void fila_proc_insere(fila_proc_t *fila, processo_t *proc)
+{
+  assert(proc->fila == NULL);
+  proc->fila = fila;
+  proc->ant_fila = fila->ult;
+  proc->prox_fila = NULL;
+  if (fila->ult == NULL) fila->prim = proc;
+  else fila->ult->prox_fila = proc;
+  fila->ult = proc;
+}
+
+// tira o processo da fila em que ele está (se estiver em alguma)
+static void fila_proc_tira(processo_t *proc)
+{
+  fila_proc_t *fila = proc->fila;
+  if (fila == NULL) return;
+  if (proc->ant_fila == NULL) fila->prim = proc->prox_fila;
+  else proc->ant_fila->prox_fila = proc->prox_fila;
+  if (proc->prox_fila == NULL) fila->ult = proc->ant_fila;
+  else proc->prox_fila->ant_fila = proc->ant_fila;
+  proc->fila = NULL;
+}
+
+// retira e retorna o primeiro processo da fila, ou NULL se ela estiver vazia
+static processo_t *fila_proc_retira(fila_proc_t *fila)
+{
+  processo_t *proc = fila->prim;
+  if (proc != NULL) fila_proc_tira(proc);
+  return proc;
+}
+
+
+// heap dos processos prontos no escalonador por prioridade, em um vetor: os
+//   filhos da posição i estão nas posições 2i+1 e 2i+2, e nenhum vem antes
+//   dele (ver prioridade_antes); escolher o processo não depende do número de
+//   prontos, e inserir ou tirar um processo depende do logaritmo desse número
+
+// retorna true se o processo 'a' deve executar antes de 'b': o de menor valor
+//   de prioridade e, entre esses, o de menor posição na tabela
+static bool prioridade_antes(processo_t *a, processo_t *b)
+{
+  if (a->prioridade != b->prioridade) return a->prioridade < b->prioridade;
+  return a->indice < b->indice;
+}
+
+// coloca o processo na posição 'pos' do heap
+static void prioridade_poe(so_t *so, int pos, processo_t *proc)
+{
+  so->prontos_prioridade[pos] = proc;
+  proc->pos_prioridade = pos;
+}
+
+// move o processo na posição 'pos' do heap até o seu lugar
+static void prioridade_arruma(so_t *so, int pos)
+{
+  processo_t **heap = so->prontos_prioridade;
+  processo_t *proc = heap[pos];
+  // sobe enquanto vier antes do pai
+  while (pos > 0 && prioridade_antes(proc, heap[(pos - 1) / 2])) {
+    prioridade_poe(so, pos, heap[(pos - 1) / 2]);
+    pos = (pos - 1) / 2;
+  }
+  // desce enquanto algum filho vier antes dele
+  for (;;) {
+    int filho = 2 * pos + 1;
+    if (filho >= so->n_prontos_prioridade) break;
+    if (filho + 1 < so->n_prontos_prioridade
+        && prioridade_antes(heap[filho + 1], heap[filho])) {
+      filho++;
     }
+    if (!prioridade_antes(heap[filho], proc)) break;
+    prioridade_poe(so, pos, heap[filho]);
+    pos = filho;
+  }
+  prioridade_poe(so, pos, proc);
+}
+
+static void prioridade_insere(so_t *so, processo_t *proc)
+{
+  assert(proc->pos_prioridade == -1);
+  if (so->n_prontos_prioridade == so->cap_prontos_prioridade) {
+    so->cap_prontos_prioridade = so->cap_prontos_prioridade == 0
+                                 ? 8 : 2 * so->cap_prontos_prioridade;
+    so->prontos_prioridade = realloc(so->prontos_prioridade,
+                                     so->cap_prontos_prioridade * sizeof(processo_t *));
+    assert(so->prontos_prioridade != NULL);
+  }
+  prioridade_poe(so, so->n_prontos_prioridade++, proc);
+  prioridade_arruma(so, proc->pos_prioridade);
+}
+
+// tira o processo do heap (se estiver nele)
+static void prioridade_tira(so_t *so, processo_t *proc)
+{
+  int pos = proc->pos_prioridade;
+  if (pos == -1) return;
+  proc->pos_prioridade = -1;
+  processo_t *ultimo = so->prontos_prioridade[--so->n_prontos_prioridade];
+  if (ultimo == proc) return;
+  prioridade_poe(so, pos, ultimo);
+  prioridade_arruma(so, pos);
+}
+
+// coloca um processo que ficou pronto no fim da fila de prontos do seu nível,
+//   ou no heap, no escalonador por prioridade
+static void so_insere_pronto(so_t *so, processo_t *proc)
+{
+  if (so->escalonador == ESCAL_PRIORIDADE) {
+    prioridade_insere(so, proc);
+  } else {
+    fila_proc_insere(&so->processos_prontos[proc->nivel], proc);
   }
-  return -1;
 }
 
 
@@ -238,63 +533,141 @@ static bool associa_terminal_a_processo(so_t *so, processo_t *proc)
 }
 
 
-int processo_cria(so_t *so, char *nome_do_executavel, int *ender_carga)
+// aumenta a tabela de processos para 'cap' posições (no máximo PID_MAX_INDICE)
+static void so_aumenta_tabela(so_t *so, int cap)
 {
-  if (so->n_processos_tabela == N_PROCESSOS)
-  {
-    console_printf("TABELA DE PROCESSOS ESTÁ CHEIA\n");
+  if (cap > PID_MAX_INDICE) cap = PID_MAX_INDICE;
+  so->tabela_de_processos = realloc(so->tabela_de_processos,
+                                    cap * sizeof(processo_t *));
+  assert(so->tabela_de_processos != NULL);
+  for (int i = so->cap_tabela; i < cap; i++) {
+    so->tabela_de_processos[i] = NULL;
+    fila_enque(so->indices_livres, i);
   }
+  so->cap_tabela = cap;
+}
+
+// retorna uma posição livre da tabela de processos, aumentando a tabela se
+//   necessário, ou -1 se ela já tiver o tamanho máximo e estiver cheia
+static int processo_pega_indice_livre(so_t *so)
+{
+  if (fila_vazia(so->indices_livres)) {
+    if (so->cap_tabela == PID_MAX_INDICE) return -1;
+    so_aumenta_tabela(so, so->cap_tabela * 2);
+  }
+  int i = fila_deque(so->indices_livres);
+  // o descritor é alocado no primeiro uso da posição, e depois reaproveitado
+  if (so->tabela_de_processos[i] == NULL) {
+    so->tabela_de_processos[i] = malloc(sizeof(processo_t));
+    assert(so->tabela_de_processos[i] != NULL);
+    so->tabela_de_processos[i]->indice = i;
+    so->tabela_de_processos[i]->geracao = 0;
+    so->tabela_de_processos[i]->fila = NULL;
+    so->tabela_de_processos[i]->pos_prioridade = -1;
+  } else {
+    processo_t *proc = so->tabela_de_processos[i];
+    proc->geracao = (proc->geracao + 1) % (PID_MAX_GERACAO + 1);
+  }
+  return i;
+}
+
 
+int processo_cria(so_t *so, char *nome_do_executavel, int *ender_carga)
+{
   // insere um novo processo na tabela
-  int i = 0;
-  while (i < N_PROCESSOS)
+  int i = processo_pega_indice_livre(so);
+  if (i == -1)
   {
-    if (so->tabela_de_processos[i].pid == SEM_PROCESSO)
-    {
-      so->tabela_de_processos[i].pid = i + 1;
-      so->tabela_de_processos[i].executavel = malloc(sizeof(nome_do_executavel));
-      strcpy(so->tabela_de_processos[i].executavel, nome_do_executavel);
-      so->tabela_de_processos[i].estado = PRONTO;
-      so->tabela_de_processos[i].dispositivo_causou_bloqueio = SEM_DISPOSITIVO;
-      so->tabela_de_processos[i].pid_esperando = SEM_PROCESSO;
-      so->tabela_de_processos[i].quantum = QUANTUM;
-      so->tabela_de_processos[i].prioridade = 0.5;
-      so->tabela_de_processos[i].tabpag = tabpag_cria();  // cria tabpag importante
-      so->tabela_de_processos[i].quadro_mem2 = 0;
-      so->tabela_de_processos[i].data_desbloqueio = 0;
-      break;
-    }
-    i++;
+    console_log(LOG_ERRO, "TABELA DE PROCESSOS ESTÁ CHEIA\n");
+    return -1;
+  }
+  processo_t *proc = so->tabela_de_processos[i];
+  proc->pid = 1 + i + proc->geracao * PID_MAX_INDICE;
+  proc->executavel = malloc(strlen(nome_do_executavel) + 1);
+  assert(proc->executavel != NULL);
+  strcpy(proc->executavel, nome_do_executavel);
+  proc->estado = PRONTO;
+  proc->dispositivo_causou_bloqueio = SEM_DISPOSITIVO;
+  proc->pid_esperando = SEM_PROCESSO;
+  proc->esperando = NULL;
+  proc->prox_esperando = NULL;
+  proc->nivel = 0;
+  proc->quantum = so->escalonador == ESCAL_MLFQ ? so->quantum_mlfq[0] : so->quantum;
+  proc->epoca_mlfq = so->epoca_mlfq;
+  proc->prioridade = 0.5;
+  proc->tabpag = tabpag_cria();  // cria tabpag importante
+  proc->n_paginas = 0;
+  proc->quadros_mem2 = NULL;
+  proc->imagem = NULL;
+  proc->pc_falta = -1;
+  proc->data_desbloqueio = 0;
+  proc->regA = proc->regX = proc->regERRO = proc->regComplemento = 0;
+  proc->terminal = -1;
+  proc->simbolos = so_simbolos_do_programa(so, nome_do_executavel);
+  so->n_processos_tabela++;
+  so->n_processos_criados++;
+  if (so->perfil != NULL) {
+    perfil_nomeia_processo(so->perfil, proc->pid, nome_do_executavel,
+                           proc->simbolos);
   }
 
   // carrega o programa na memória
-  int endereco_inicial = so_carrega_programa(so, &so->tabela_de_processos[i], nome_do_executavel);
+  int endereco_inicial = so_carrega_programa(so, proc, nome_do_executavel);
   if (ender_carga != NULL) memcpy(ender_carga, &endereco_inicial, sizeof(int));
-  so->tabela_de_processos[i].regPC = endereco_inicial;
+  proc->regPC = endereco_inicial;
 
   // verifica se o endereço é válido
   if (endereco_inicial < 0) {
-    console_printf("SO: problema na carga de um programa");
+    console_log(LOG_ERRO, "SO: problema na carga de um programa");
     so->erro_interno = true;
     return -1;
   }
 
   // vê se tem um terminal disponível e associa ao processo
-  if (!associa_terminal_a_processo(so, &so->tabela_de_processos[i]))
+  if (!associa_terminal_a_processo(so, proc))
   {
-    so->tabela_de_processos[i].terminal = -1;
-    console_printf("TERMINAL NÃO ASSOCIADO");
+    proc->terminal = -1;
+    console_log(LOG_INFO, "TERMINAL NÃO ASSOCIADO");
   }
 
   // insere na fila de processo prontos
-  fila_enque(so->processos_prontos, so->tabela_de_processos[i].pid);
+  so_insere_pronto(so, proc);
 
   // imprime tabela para debugar
-  console_printf("Processo criado\n");
+  console_log(LOG_INFO, "Processo criado\n");
   tablea_proc_imprime(so);
 
-  so->n_processos_tabela++;
-  return so->tabela_de_processos[i].pid;
+  return proc->pid;
+}
+
+
+// desbloqueia um processo, colocando-o no fim da fila de prontos
+static void processo_desbloqueia(so_t *so, processo_t *proc)
+{
+  // se houve elevação dos níveis do MLFQ enquanto estava bloqueado, volta
+  //   para o nível 0 agora (ver so_eleva_processos_mlfq)
+  if (proc->epoca_mlfq != so->epoca_mlfq) {
+    proc->epoca_mlfq = so->epoca_mlfq;
+    proc->nivel = 0;
+    proc->quantum = so->quantum_mlfq[0];
+  }
+  proc->estado = PRONTO;
+  proc->dispositivo_causou_bloqueio = SEM_DISPOSITIVO;
+  proc->data_desbloqueio = 0;
+  so_insere_pronto(so, proc);
+}
+
+
+// tira o processo da lista dos que esperam a morte de outro
+static void processo_para_de_esperar(so_t *so, processo_t *proc)
+{
+  processo_t *esperado = acha_processo_por_pid(so, proc->pid_esperando);
+  proc->pid_esperando = SEM_PROCESSO;
+  if (esperado == NULL) return;
+  processo_t **pp = &esperado->esperando;
+  while (*pp != NULL && *pp != proc) pp = &(*pp)->prox_esperando;
+  if (*pp == proc) *pp = proc->prox_esperando;
+  proc->prox_esperando = NULL;
 }
 
 
@@ -303,98 +676,105 @@ void processo_mata(so_t *so, int pid)
   // verifica se hà processos para serem deletados
   if (so->n_processos_tabela <= 0)
   {
-    console_printf("SO TENTOU MATAR UM PROCESSO QUANDO NÃO HÁ PROCESSOS CORRENTES\n");
+    console_log(LOG_ERRO, "SO TENTOU MATAR UM PROCESSO QUANDO NÃO HÁ PROCESSOS CORRENTES\n");
     return;
   }
 
+  // pid 0 é o processo corrente
+  processo_t *proc = pid == 0 ? so->processo_corrente : acha_processo_por_pid(so, pid);
+  if (proc == NULL || proc->pid == SEM_PROCESSO) return;
+  pid = proc->pid;
+
   so->n_processos_tabela--;
 
-  if (pid == 0)
+  so_libera_memoria_do_processo(so, proc);
+  // tira dos prontos ou da fila de espera do dispositivo
+  bool esperava_dispositivo = proc->fila != NULL && proc->estado == BLOQUEADO;
+  fila_proc_tira(proc);
+  prioridade_tira(so, proc);
+  if (esperava_dispositivo)
   {
-    // mata o processo corrente
-    free(so->processo_corrente->executavel);
-    so->processo_corrente->estado = FINALIZADO;
-    so->processo_corrente->pid = SEM_PROCESSO;
-    so->processo_corrente->terminal = -1;
-    tabpag_destroi(so->processo_corrente->tabpag);
-    for (int i = 0; i < N_TERMINAIS; i++)
-    {
-      if (so->terminais_usados[i] == so->processo_corrente->pid)
-      {
-        so->terminais_usados[i] = SEM_PROCESSO;
-      }
-    }
-    fila_deque(so->processos_prontos);
+    so_atualiza_interrupcoes(so, proc->dispositivo_causou_bloqueio);
   }
-  else
+  processo_para_de_esperar(so, proc);
+  free(proc->executavel);
+  proc->executavel = NULL;
+  proc->estado = FINALIZADO;
+  proc->terminal = -1;
+  tabpag_destroi(proc->tabpag);
+  for (int i = 0; i < N_TERMINAIS; i++)
   {
-    for (int i = 0; i < N_PROCESSOS; i++)
+    if (so->terminais_usados[i] == pid)
     {
-      if (so->tabela_de_processos[i].pid == pid)
-      {
-        free(so->tabela_de_processos[i].executavel);
-        so->tabela_de_processos[i].estado = FINALIZADO;
-        so->tabela_de_processos[i].pid = SEM_PROCESSO;
-        so->tabela_de_processos[i].terminal = -1;
-        tabpag_destroi(so->tabela_de_processos[i].tabpag);
-        for (int j = 0; j < N_TERMINAIS; j++)
-        {
-          if (so->terminais_usados[j] == so->tabela_de_processos[i].pid)
-          {
-            so->terminais_usados[j] = SEM_PROCESSO;
-          }
-        }
-      }
-
+      so->terminais_usados[i] = SEM_PROCESSO;
     }
   }
 
-  // verifica se tinha algum processo esperado a morte desse
-  for (int i = 0; i < N_PROCESSOS; i++)
+  // desbloqueia os processos que esperavam a morte desse
+  while (proc->esperando != NULL)
   {
-    if (so->tabela_de_processos[i].pid_esperando == pid)
+    processo_t *p = proc->esperando;
+    proc->esperando = p->prox_esperando;
+    p->prox_esperando = NULL;
+    p->pid_esperando = SEM_PROCESSO;
+    if (p->estado == BLOQUEADO)
     {
-      so->tabela_de_processos[i].estado = PRONTO;
-      fila_enque(so->processos_prontos, so->tabela_de_processos[i].pid);
+      processo_desbloqueia(so, p);
     }
   }
+
+  // a posição na tabela pode ser reusada (o descritor continua existindo, e
+  //   pode continuar sendo o corrente até o escalonador escolher outro)
+  proc->pid = SEM_PROCESSO;
+  fila_enque(so->indices_livres, proc->indice);
 }
 
 
-void processo_troca_corrente(so_t *self)
+// coloca um processo pronto em execução, como processo corrente
+static void processo_executa(so_t *self, processo_t *proc)
 {
-  // por enquanto, acha o primeiro processo existente na tabela
-  int i = 0;
-  while (i < N_PROCESSOS)
-  {
-    if (self->tabela_de_processos[i].pid != SEM_PROCESSO && self->tabela_de_processos[i].estado == PRONTO)
-    {
-      self->processo_corrente = &self->tabela_de_processos[i];
-      self->processo_corrente->estado = EXECUCAO;
-      mmu_define_tabpag(self->mmu, self->processo_corrente->tabpag);
-      break;
-    }
-    i++;
-  }
+  if (proc != self->processo_corrente) self->n_trocas++;
+  self->processo_corrente = proc;
+  if (self->perfil != NULL) perfil_define_processo(self->perfil, proc->pid);
+  cpu_define_simbolos(self->cpu, self->simbolos_so, proc->simbolos);
+  proc->estado = EXECUCAO;
+  // no MLFQ, o quantum do nível é gasto aos poucos, mesmo que o processo
+  //   bloqueie antes do fim, senão bastaria bloquear para não descer
+  if (self->escalonador != ESCAL_MLFQ) proc->quantum = self->quantum;
+  mmu_define_tabpag(self->mmu, proc->tabpag);
 }
 
 
-// verifica se um processo com o pid existe
-static bool processo_existe(so_t *self, int pid)
+void processo_troca_corrente(so_t *self)
 {
-  for (int i = 0; i < N_PROCESSOS; i++)
+  // no escalonador por prioridade, o primeiro do heap
+  if (self->escalonador == ESCAL_PRIORIDADE)
+  {
+    if (self->n_prontos_prioridade == 0) return;
+    processo_t *proc = self->prontos_prioridade[0];
+    prioridade_tira(self, proc);
+    processo_executa(self, proc);
+    return;
+  }
+  // senão, o primeiro processo da fila de prontos de nível mais alto
+  for (int nivel = 0; nivel < N_NIVEIS_MLFQ; nivel++)
   {
-    if (self->tabela_de_processos[i].pid == pid) return true;
+    processo_t *proc = fila_proc_retira(&self->processos_prontos[nivel]);
+    if (proc != NULL)
+    {
+      processo_executa(self, proc);
+      return;
+    }
   }
-  return false;
 }
 
 
-// atualiza a prioridade de um processo
-static void processo_atualiza_prioridade(processo_t *proc)
+// atualiza a prioridade de um processo, quando ele deixa de executar
+static void processo_atualiza_prioridade(so_t *so, processo_t *proc)
 {
   // prio = (prio + t_exec/t_quantum) / 2
-  proc->prioridade = (proc->prioridade + proc->quantum / QUANTUM) / 2;
+  float t_exec = so->quantum - proc->quantum;
+  proc->prioridade = (proc->prioridade + t_exec / so->quantum) / 2;
 }
 
 
@@ -415,31 +795,78 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_secundaria, mmu_t *mmu,
   self->es = es;
   self->console = console;
   self->erro_interno = false;
-  self->mem2_livre = true;
-  self->mem2_tempo_ate_livre = 0;
-
-  self->tabquadros = malloc(MEM_TAM / TAM_PAGINA * sizeof(quadro_t));
+  self->cap_pedidos_disco = 8;
+  self->pedidos_disco = malloc(self->cap_pedidos_disco * sizeof(pedido_disco_t));
+  assert(self->pedidos_disco != NULL);
+  self->n_pedidos_disco = 0;
+  self->prim_pedido_disco = 0;
+  self->imagens = NULL;
+  self->escalonador = ESCAL_SIMPLES;
+  self->intervalo_relogio = SO_INTERVALO_RELOGIO;
+  self->quantum = SO_QUANTUM;
+  int quantum_mlfq[N_NIVEIS_MLFQ] = QUANTUM_MLFQ;
+  memcpy(self->quantum_mlfq, quantum_mlfq, sizeof(quantum_mlfq));
+  self->t_elevacao_mlfq = PERIODO_ELEVACAO_MLFQ;
+  self->epoca_mlfq = 0;
+  self->programa_inicial = NULL;
+  self->perfil = NULL;
+  // a bios é carregada pelo main, e o tratador de interrupção em
+  //   so_trata_reset; os dois executam em modo supervisor
+  self->simbolos_so = simbolos_cria();
+  simbolos_le(self->simbolos_so, "bios.maq");
+  simbolos_le(self->simbolos_so, "trata_int.maq");
+  self->simbolos_programas = NULL;
+  cpu_define_simbolos(self->cpu, self->simbolos_so, NULL);
+  so_define_programa_inicial(self, "init.maq");
+  self->n_processos_criados = 0;
+  self->n_trocas = 0;
+  self->n_preempcoes = 0;
+  self->substituicao = SUBST_FIFO;
+  self->n_cargas = 0;
+  self->prim_carga = -1;
+  self->ult_carga = -1;
+  self->n_faltas = 0;
+  self->n_substituicoes = 0;
+  self->n_escritas_mem2 = 0;
+
+  self->tam_pagina = mmu_tam_pagina(mmu);
+  int n_quadros = mem_tam(mem) / self->tam_pagina;
+  self->quadros_mem = quadros_cria(n_quadros);
+  self->quadros_mem2 = quadros_cria(mem_tam(mem_secundaria) / self->tam_pagina);
+  self->tabquadros = malloc(n_quadros * sizeof(quadro_t));
   assert(self->tabquadros != NULL);
-  for (int i = 0; i < MEM_TAM/TAM_PAGINA; i++){
+  for (int i = 0; i < n_quadros; i++){
     self->tabquadros[i].pagina = -1;
-    self->tabquadros[i].pid = SEM_PROCESSO;
+    self->tabquadros[i].em_transferencia = false;
+    self->tabquadros[i].nova = false;
+    self->tabquadros[i].na_ordem_de_carga = false;
   }
 
   // cria tabela de processo
-  self->tabela_de_processos = malloc(N_PROCESSOS * sizeof(processo_t));
-  assert(self->tabela_de_processos != NULL);
-  for (int i = 0; i < N_PROCESSOS; i++) 
-  {
-    self->tabela_de_processos[i].pid = SEM_PROCESSO;
-  }
+  self->cap_tabela = 0;
+  self->tabela_de_processos = NULL;
+  self->indices_livres = fila_cria();
+  so_aumenta_tabela(self, SO_N_PROCESSOS);
   self->n_processos_tabela = 0;
-  self->processo_corrente = &self->tabela_de_processos[0];
-  self->processos_prontos = fila_cria();
+  memset(&self->sem_processo, 0, sizeof(self->sem_processo));
+  self->sem_processo.pid = SEM_PROCESSO;
+  self->sem_processo.pos_prioridade = -1;
+  self->sem_processo.estado = FINALIZADO;
+  self->processo_corrente = &self->sem_processo;
+  memset(self->processos_prontos, 0, sizeof(self->processos_prontos));
+  memset(self->espera_dispositivo, 0, sizeof(self->espera_dispositivo));
+  self->prontos_prioridade = NULL;
+  self->n_prontos_prioridade = 0;
+  self->cap_prontos_prioridade = 0;
+  self->alarmes = alarmes_cria();
 
   // inicializa vetor de terminais usados
   for (int i = 0; i < N_TERMINAIS; i++)
   {
     self->terminais_usados[i] = SEM_PROCESSO;
+    self->interrupcoes_terminal[i] = 0;
+    self->saida_terminal[i].prim = 0;
+    self->saida_terminal[i].n = 0;
   }
 
   // quando a CPU executar uma instrução CHAMAC, deve chamar a função
@@ -458,6 +885,41 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_secundaria, mmu_t *mmu,
 void so_destroi(so_t *self)
 {
   cpu_define_chamaC(self->cpu, NULL, NULL);
+  cpu_define_simbolos(self->cpu, NULL, NULL);
+  quadros_destroi(self->quadros_mem);
+  quadros_destroi(self->quadros_mem2);
+  free(self->tabquadros);
+  free(self->pedidos_disco);
+  free(self->prontos_prioridade);
+  alarmes_destroi(self->alarmes);
+  fila_destroi(self->indices_livres);
+  free(self->programa_inicial);
+  for (int i = 0; i < self->cap_tabela; i++) {
+    processo_t *proc = self->tabela_de_processos[i];
+    if (proc == NULL) continue;
+    if (proc->pid != SEM_PROCESSO) {
+      free(proc->executavel);
+      free(proc->quadros_mem2);
+      tabpag_destroi(proc->tabpag);
+    }
+    free(proc);
+  }
+  free(self->tabela_de_processos);
+  while (self->imagens != NULL) {
+    imagem_t *imagem = self->imagens;
+    self->imagens = imagem->prox;
+    free(imagem->nome);
+    free(imagem->blocos);
+    free(imagem);
+  }
+  while (self->simbolos_programas != NULL) {
+    simbolos_programa_t *sp = self->simbolos_programas;
+    self->simbolos_programas = sp->prox;
+    free(sp->nome);
+    simbolos_destroi(sp->simbolos);
+    free(sp);
+  }
+  simbolos_destroi(self->simbolos_so);
   free(self);
 }
 
@@ -472,6 +934,7 @@ static void so_trata_irq(so_t *self, int irq);
 static void so_trata_pendencias(so_t *self);
 static void so_escalona(so_t *self);
 static int so_despacha(so_t *self);
+static bool so_tenta_es(so_t *self, processo_t *proc, int dispositivo);
 
 // função a ser chamada pela CPU quando executa a instrução CHAMAC, no tratador de
 //   interrupção em assembly
@@ -492,7 +955,7 @@ static int so_trata_interrupcao(void *argC, int reg_A)
   so_t *self = argC;
   irq_t irq = reg_A;
   // esse print polui bastante, recomendo tirar quando estiver com mais confiança
-  console_printf("SO: recebi IRQ %d (%s)", irq, irq_nome(irq));
+  console_log(LOG_DEPURA, "SO: recebi IRQ %d (%s)", irq, irq_nome(irq));
   // salva o estado da cpu no descritor do processo que foi interrompido
   so_salva_estado_da_cpu(self);
   // faz o atendimento da interrupção
@@ -515,7 +978,9 @@ static void so_salva_estado_da_cpu(so_t *self)
   // se não houver processo corrente, não faz nada
 
   // verifica se há um processo corrente
-  if (self->processo_corrente->pid == SEM_PROCESSO)
+  // se ele estiver bloqueado, a CPU estava parada e o estado dele já foi salvo
+  if (self->processo_corrente->pid == SEM_PROCESSO
+      || self->processo_corrente->estado == BLOQUEADO)
   {
     return;
   }
@@ -526,7 +991,7 @@ static void so_salva_estado_da_cpu(so_t *self)
       || mem_le(self->mem, CPU_END_erro, &self->regERRO) != ERR_OK
       || mem_le(self->mem, CPU_END_complemento, &self->regComplemento) != ERR_OK
       || mem_le(self->mem, 59, &self->regX)) {
-    console_printf("SO: erro na leitura dos registradores");
+    console_log(LOG_ERRO, "SO: erro na leitura dos registradores");
     self->erro_interno = true;
   }
 
@@ -553,58 +1018,40 @@ static void so_trata_pendencias(so_t *self)
   // "na função que trata de pendências, o SO deve verificar o estado dos dispositivos 
   // que causaram bloqueio e realizar operações pendentes e desbloquear processos se for o caso"
 
-  // verifica o estado dos dispositivos bloqueados
-  for (int i = 0; i < N_PROCESSOS; i++)
+  // os processos bloqueados esperando um terminal são atendidos nas
+  //   interrupções do terminal, os que esperam o disco na interrupção do
+  //   disco, e os que esperam a morte de outro processo nessa morte
+
+  // acorda os processos cujo alarme já passou, em ordem de data; os alarmes
+  //   de processos que morreram enquanto dormiam são descartados
+  if (alarmes_vazio(self->alarmes)) return;
+  int agora;
+  if (es_le(self->es, D_RELOGIO_INSTRUCOES, &agora) != ERR_OK)
   {
-    processo_t *p = &self->tabela_de_processos[i];
-    if (p->estado == BLOQUEADO)
+    console_log(LOG_ERRO, "SO: problema no acesso ao relógio");
+    self->erro_interno = true;
+    return;
+  }
+  while (!alarmes_vazio(self->alarmes)
+         && alarmes_proxima_data(self->alarmes) <= agora)
+  {
+    processo_t *p = acha_processo_por_pid(self, alarmes_retira(self->alarmes));
+    if (p != NULL && p->estado == BLOQUEADO && p->data_desbloqueio != 0)
     {
-      // verifica o dispositivo que causou o bloqueio
-      int dispositivo = p->dispositivo_causou_bloqueio;
-      int operacao = dispositivo % 4;
-
-      // verifica o estado do dispositivo
-      int disponivel;
-      int estado = es_le(self->es, dispositivo, &disponivel);
-      if (estado != ERR_OK)
-      {
-        // realiza a operação pendente
-        // leitura
-        if (operacao == 1)
-        {
-          int dado;
-          if (es_le(self->es, dispositivo-1, &dado) != ERR_OK) {
-            console_printf("SO: problema no acesso ao teclado");
-            self->erro_interno = true;
-            return;
-          }
-          p->regA = dado;
-        }
-        // escrita
-        if (operacao == 3)
-        {
-          int dado = p->regX;
-          if (es_escreve(self->es, dispositivo-1, dado) != ERR_OK) {
-            console_printf("SO: problema no acesso à tela");
-            self->erro_interno = true;
-            return;
-          }
-          p->regA = 0;
-        }
-      }
+      processo_desbloqueia(self, p);
+    }
+  }
+}
 
-      // desbloqueia o processo se tiver na hora
-      int agora = relogio_agora();
-      if (p->data_desbloqueio <= agora)
-      {
-        p->estado = PRONTO;
-        p->dispositivo_causou_bloqueio = SEM_DISPOSITIVO;
-        p->data_desbloqueio = 0;
-        fila_enque(self->processos_prontos, p->pid);
-      }
 
-    }
+// retorna true se tiver algum processo pronto em nível mais alto que 'nivel'
+static bool so_tem_pronto_acima(so_t *self, int nivel)
+{
+  for (int n = 0; n < nivel; n++)
+  {
+    if (!fila_proc_vazia(&self->processos_prontos[n])) return true;
   }
+  return false;
 }
 
 
@@ -612,70 +1059,105 @@ static void so_escalona(so_t *self)
 {
   // escolhe o próximo processo a executar, que passa a ser o processo
   //   corrente; pode continuar sendo o mesmo de antes ou não
-  // t2: na primeira versão, escolhe um processo pronto caso o processo
-  //   corrente não possa continuar executando, senão deixa o mesmo processo.
-  //   depois, implementa um escalonador melhor
+  processo_t *corrente = self->processo_corrente;
 
   // verifica se o processo corrente está em execução
-  if (self->processo_corrente->estado == EXECUCAO) return;
+  if (corrente->estado == EXECUCAO)
+  {
+    // no MLFQ, perde a CPU para um processo de nível mais alto que tenha
+    //   ficado pronto (um processo de E/S que foi desbloqueado, por exemplo)
+    if (self->escalonador != ESCAL_MLFQ
+        || !so_tem_pronto_acima(self, corrente->nivel)) return;
+    corrente->estado = PRONTO;
+    fila_proc_insere(&self->processos_prontos[corrente->nivel], corrente);
+    self->n_preempcoes++;
+  }
 
-  switch (ESCALONADOR)
+  switch (self->escalonador)
   {
-    case ROUND_ROBIN:
-      console_printf("ROUND ROBIN\n");
-      // pega o primeiro processo da fila de processos prontos
-      int pid_escalonado = fila_get(self->processos_prontos, 0);
-      for (int i = 0; i < N_PROCESSOS; i++)
-      {
-        if (self->tabela_de_processos[i].pid == pid_escalonado && pid_escalonado != -1)
-        {
-          // torna-o o processo corrente
-          self->processo_corrente = &self->tabela_de_processos[i];
-          mmu_define_tabpag(self->mmu, self->processo_corrente->tabpag);
-        }
-      }
+    case ESCAL_PRIORIDADE:
+      console_log(LOG_DEPURA, "PRIORIDADE\n");
+      // o pronto de maior prioridade (menor valor do campo ->prioridade)
+      processo_troca_corrente(self);
       break;
 
-    case PRIORIDADE:
-      console_printf("PRIORIDADE\n");
-      // pega o indice do processo com a maior prioridade na tabela de processos (menor valor do campo ->prioridade)
-      int indice_maior_prioridade = SEM_PROCESSO;
-      float maior_prioridade = QUANTUM;
-      for (int i = 0; i < N_PROCESSOS; i++)
-      {
-        if (self->tabela_de_processos[i].estado == FINALIZADO) continue;
+    case ESCAL_MLFQ:
+      console_log(LOG_DEPURA, "MLFQ\n");
+      // o primeiro processo da fila de nível mais alto que não está vazia
+      processo_troca_corrente(self);
+      break;
 
-        if (self->tabela_de_processos[i].prioridade < maior_prioridade)
-        {
-          indice_maior_prioridade = i;
-          maior_prioridade = self->tabela_de_processos[i].prioridade;
-        }
-      }
-      // escalona o processo de maior prioridade
-      if (indice_maior_prioridade != SEM_PROCESSO)
-      {
-        self->processo_corrente = &self->tabela_de_processos[indice_maior_prioridade];
-        mmu_define_tabpag(self->mmu, self->processo_corrente->tabpag);
-      }
-      else
-      {
-        // apenas tem um processo na tabela - deixa ele corrente
-        processo_troca_corrente(self);
-      }
+    case ESCAL_ROUND_ROBIN:
+      console_log(LOG_DEPURA, "ROUND ROBIN\n");
+      // pega o primeiro processo da fila de processos prontos
+      processo_troca_corrente(self);
       break;
 
     default:
-      console_printf("NENHUM\n");
+      console_log(LOG_DEPURA, "NENHUM\n");
       // bota o primeiro processo PRONTO para executar
       processo_troca_corrente(self);
   }
 
   // imprime tabela para debugar
-  console_printf("Processo escalonado\n");
+  console_log(LOG_DEPURA, "Processo escalonado\n");
   tablea_proc_imprime(self);
 }
 
 
+char *so_nome_escalonador(so_escalonador_t alg)
+{
+  switch (alg) {
+    case ESCAL_SIMPLES:     return "simples";
+    case ESCAL_ROUND_ROBIN: return "round_robin";
+    case ESCAL_PRIORIDADE:  return "prioridade";
+    case ESCAL_MLFQ:        return "mlfq";
+    default:                return "???";
+  }
+}
+
+void so_define_escalonador(so_t *self, so_escalonador_t alg)
+{
+  assert(alg >= 0 && alg < N_ESCAL);
+  self->escalonador = alg;
+}
+
+void so_define_n_processos(so_t *self, int n_processos)
+{
+  assert(n_processos > 0);
+  if (n_processos > self->cap_tabela) so_aumenta_tabela(self, n_processos);
+}
+
+void so_define_perfil(so_t *self, perfil_t *perfil)
+{
+  self->perfil = perfil;
+  if (perfil != NULL) perfil_define_simbolos_so(perfil, self->simbolos_so);
+}
+
+void so_define_programa_inicial(so_t *self, char *nome)
+{
+  free(self->programa_inicial);
+  self->programa_inicial = malloc(strlen(nome) + 1);
+  assert(self->programa_inicial != NULL);
+  strcpy(self->programa_inicial, nome);
+}
+
+void so_estatisticas_escalonamento(so_t *self, long *pprocessos,
+                                   long *ptrocas, long *ppreempcoes)
+{
+  *pprocessos = self->n_processos_criados;
+  *ptrocas = self->n_trocas;
+  *ppreempcoes = self->n_preempcoes;
+}
+
+void so_define_quantum(so_t *self, int intervalo, int quantum)
+{
+  assert(intervalo >= SO_INTERVALO_RELOGIO_MIN && quantum > 0);
+  self->intervalo_relogio = intervalo;
+  self->quantum = quantum;
+}
+
+
 static int so_despacha(so_t *self)
 {
   // t2: se houver processo corrente, coloca o estado desse processo onde ele
@@ -684,8 +1166,19 @@ static int so_despacha(so_t *self)
   // o valor retornado será o valor de retorno de CHAMAC, e será colocado no 
   //   registrador A para o tratador de interrupção (ver trata_irq.asm).
 
-  // verifica se há processo corrente
-  if (self->processo_corrente->pid == SEM_PROCESSO)
+  // se o SO não tem mais o que fazer (não tem mais processos, ou teve um
+  //   erro interno), desliga o timer, para que a CPU fique parada de vez
+  if (self->n_processos_tabela == 0 || self->erro_interno)
+  {
+    console_log(LOG_INFO, "SO: nada mais a executar, desligando o timer");
+    es_escreve(self->es, D_RELOGIO_TIMER, 0);
+    return 1;
+  }
+
+  // verifica se há processo corrente (se ele estiver bloqueado, não tem
+  //   nenhum processo pronto, e a CPU fica parada esperando uma interrupção)
+  if (self->processo_corrente->pid == SEM_PROCESSO
+      || self->processo_corrente->estado == BLOQUEADO)
   {
     return 1;
   }
@@ -698,7 +1191,7 @@ static int so_despacha(so_t *self)
       || mem_escreve(self->mem, CPU_END_erro, self->processo_corrente->regERRO) != ERR_OK
       || mem_escreve(self->mem, CPU_END_complemento, self->processo_corrente->regComplemento) != ERR_OK
       || mem_escreve(self->mem, 59, self->processo_corrente->regX)) {
-    console_printf("SO: erro na escrita dos registradores");
+    console_log(LOG_ERRO, "SO: erro na escrita dos registradores");
     self->erro_interno = true;
   }
   if (self->erro_interno) return 1;
@@ -716,9 +1209,20 @@ static void so_trata_irq_chamada_sistema(so_t *self);
 static void so_trata_irq_err_cpu(so_t *self);
 static void so_trata_irq_relogio(so_t *self);
 static void so_trata_irq_desconhecida(so_t *self, int irq);
+static void so_trata_irq_disco(so_t *self);
+static void so_trata_irq_terminal(so_t *self, int subdispositivo);
+static void so_trata_falta_de_pagina(so_t *self);
+static void so_atualiza_idade_das_paginas(so_t *self);
+static void so_desprotege_paginas_do_processo(so_t *self, processo_t *proc);
 
 static void so_trata_irq(so_t *self, int irq)
 {
+  // se o processo interrompido não está mais na instrução que causou a última
+  //   falta de página, ele progrediu
+  if (self->processo_corrente->estado == EXECUCAO
+      && self->processo_corrente->regPC != self->processo_corrente->pc_falta) {
+    so_desprotege_paginas_do_processo(self, self->processo_corrente);
+  }
   // verifica o tipo de interrupção que está acontecendo, e atende de acordo
   switch (irq) {
     case IRQ_RESET:
@@ -733,6 +1237,15 @@ static void so_trata_irq(so_t *self, int irq)
     case IRQ_RELOGIO:
       so_trata_irq_relogio(self);
       break;
+    case IRQ_DISCO:
+      so_trata_irq_disco(self);
+      break;
+    case IRQ_TECLADO:
+      so_trata_irq_terminal(self, TERM_TECLADO_OK);
+      break;
+    case IRQ_TELA:
+      so_trata_irq_terminal(self, TERM_TELA_OK);
+      break;
     default:
       so_trata_irq_desconhecida(self, irq);
   }
@@ -749,28 +1262,24 @@ static void so_trata_reset(so_t *self)
   //   de interrupção (escrito em asm). esse programa deve conter a
   //   instrução CHAMAC, que vai chamar so_trata_interrupcao (como
   //   foi definido na inicialização do SO)
-  processo_t *p = (processo_t*) malloc(sizeof(processo_t));
-  p->pid = SEM_PROCESSO;
-  int ender = so_carrega_programa(self, p, "trata_int.maq");
+  int ender = so_carrega_programa(self, &self->sem_processo, "trata_int.maq");
   if (ender != CPU_END_TRATADOR) {
-    console_printf("SO: problema na carga do programa de tratamento de interrupção");
+    console_log(LOG_ERRO, "SO: problema na carga do programa de tratamento de interrupção");
     self->erro_interno = true;
   }
 
-  // programa o relógio para gerar uma interrupção após INTERVALO_INTERRUPCAO
-  if (es_escreve(self->es, D_RELOGIO_TIMER, INTERVALO_INTERRUPCAO) != ERR_OK) {
-    console_printf("SO: problema na programação do timer");
+  // programa o relógio para gerar uma interrupção após intervalo_relogio
+  if (es_escreve(self->es, D_RELOGIO_TIMER, self->intervalo_relogio) != ERR_OK) {
+    console_log(LOG_ERRO, "SO: problema na programação do timer");
     self->erro_interno = true;
   }
 
-  // define o primeiro quadro livre de memória como o seguinte àquele que
-  //   contém o endereço final da memória protegida (que não podem ser usadas
-  //   por programas de usuário)
-  // t3: o controle de memória livre deve ser mais aprimorado que isso  
-  self->quadro_livre_mem = CPU_END_FIM_PROT / TAM_PAGINA + 1;
-  self->quadro_livre_mem2 = 0;
-  // marca os quadros de memória protegida como nao livres;
-  for (int i = 0; i < self->quadro_livre_mem + 1; i++) self->tabquadros[i].pid = PROTEGIDO;
+  // reserva os quadros até o seguinte àquele que contém o endereço final da
+  //   memória protegida (que não podem ser usados por programas de usuário)
+  int ultimo_quadro_protegido = CPU_END_FIM_PROT / self->tam_pagina + 1;
+  for (int i = 0; i <= ultimo_quadro_protegido; i++) {
+    quadros_reserva(self->quadros_mem, i, PROTEGIDO);
+  }
 
   // t2: deveria criar um processo para o init, e inicializar o estado do
   //   processador para esse processo com os registradores zerados, exceto
@@ -782,56 +1291,15 @@ static void so_trata_reset(so_t *self)
   //   em bios.asm (que é onde está a instrução CHAMAC que causou a execução
   //   deste código
 
-  // coloca o programa init na memória
-  int pid = processo_cria(self, "init.maq", NULL);
+  // coloca o programa inicial na memória
+  int pid = processo_cria(self, self->programa_inicial, NULL);
   processo_troca_corrente(self);
-  console_printf("TROCOU PRO INIT");
+  console_log(LOG_DEPURA, "TROCOU PRO INIT");
   self->processo_corrente->estado = EXECUCAO;
   self->processo_corrente->regA = pid;
 }
 
 
-static void trata_falta_de_pagina(so_t *self, int quadro_livre)
-{
-  // marca o quadro encontrado como não livre
-  self->tabquadros[quadro_livre].pid = self->processo_corrente->pid;
-  // pega a pagina do endereço virtual que causou a interrupção
-  int end = self->processo_corrente->regComplemento;
-  int pagina = end / TAM_PAGINA;
-  // copia a página da memória secundária para o quadro livre
-  int end_virt_ini = pagina * TAM_PAGINA;
-  int end_virt_fim = end_virt_ini + TAM_PAGINA - 1;
-  int end_mem2_ini = self->processo_corrente->quadro_mem2 * TAM_PAGINA + (end - end % TAM_PAGINA);
-  int end_mem2 = end_mem2_ini;
-  for (int end_virt = end_virt_ini; end_virt <= end_virt_fim; end_virt++)
-  {
-    // lê o dado da memória secundária
-    int dado;
-    if (mem_le(self->mem2, end_mem2, &dado) != ERR_OK) 
-    {
-      console_printf("ERRO NO TRATAMENTO DA PAGE FAULT");
-      return;
-    }
-    end_mem2++;
-    // copia o dado lido para a memória principal
-    int end_mem_principal = quadro_livre * TAM_PAGINA + (end_virt - end_virt_ini);
-    if (mem_escreve(self->mem, end_mem_principal, dado) != ERR_OK)
-    {
-      console_printf("ERRO NO TRATAMENTO DA PAGE FAULT");
-      return;
-    }
-  }
-
-  console_printf("SUBSTITUIU QUADRO %d (mem) por %d (mem2)", quadro_livre, pagina);
-  // altera a tabela de páginas do processo para indicar que a página está nesse quadro
-  tabpag_define_quadro(self->processo_corrente->tabpag, pagina, quadro_livre);
-  if (tabpag_bit_acesso(self->processo_corrente->tabpag, pagina))
-  {
-    console_printf("TRADUÇÃO REALIZADA");
-  }
-}
-
-
 // interrupção gerada quando a CPU identifica um erro
 static void so_trata_irq_err_cpu(so_t *self)
 {
@@ -848,65 +1316,180 @@ static void so_trata_irq_err_cpu(so_t *self)
   // verifica se o erro foi uma falta de página
   if (err == ERR_PAG_AUSENTE)
   {
-    console_printf("FALTA DE PAGINA");
-    // verifica se tem um quadro livre na memória principal
-    int quadro_livre = acha_quadro_livre(self);
-    if (quadro_livre != -1)
-    {
-      // verifica se o disco está livre
-      int agora = relogio_agora();
-      if (self->mem2_livre)
-      {
-        // trata falta de página es estiver livre
-        trata_falta_de_pagina(self, quadro_livre);
-        // "se o disco estiver livre, atualiza-se esse tempo (bloqueio do processo) para "agora" mais o tempo de espera"
-        self->processo_corrente->data_desbloqueio = agora + TEMPO_SWAP;
-      }
-      else
-      {
-        // "se não estiver, soma-se o tempo de espera a essa variável (tempo de bloqueio do processo).
-        self->processo_corrente->data_desbloqueio += TEMPO_SWAP;
-      }
-      self->processo_corrente->estado = BLOQUEADO;
-    }
-    else
-    {
-      // substituição de página
-      console_printf("SUBSTITUIÇÃO DE PÁGINA");
-    }
+    so_trata_falta_de_pagina(self);
     return;
-
   }
   else
   {
-    console_printf("SO: IRQ não tratada -- erro na CPU: %s (%d)",
+    console_log(LOG_ERRO, "SO: IRQ não tratada -- erro na CPU: %s (%d)",
     err_nome(err), self->regComplemento);
-    console_printf("pid%d PC%d", self->processo_corrente->pid, self->processo_corrente->regPC);
+    char pc[40];
+    simbolos_descreve(self->processo_corrente->simbolos,
+                      self->processo_corrente->regPC, pc, sizeof(pc));
+    console_log(LOG_ERRO, "pid%d PC%d (%s)", self->processo_corrente->pid,
+                self->processo_corrente->regPC, pc);
     self->erro_interno = true;
   }
 }
 
+// coloca todos os processos no nível 0 do MLFQ, para que os que desceram
+//   por usar muito a CPU não fiquem sem executar
+// só os prontos e o corrente são alterados aqui; os bloqueados ficam com a
+//   época antiga e são alterados quando desbloquearem (processo_desbloqueia)
+static void so_eleva_processos_mlfq(so_t *self)
+{
+  self->epoca_mlfq++;
+  for (int n = 1; n < N_NIVEIS_MLFQ; n++) {
+    processo_t *proc;
+    while ((proc = fila_proc_retira(&self->processos_prontos[n])) != NULL) {
+      fila_proc_insere(&self->processos_prontos[0], proc);
+    }
+  }
+  for (processo_t *proc = self->processos_prontos[0].prim; proc != NULL;
+       proc = proc->prox_fila) {
+    proc->epoca_mlfq = self->epoca_mlfq;
+    proc->nivel = 0;
+    proc->quantum = self->quantum_mlfq[0];
+  }
+  processo_t *corrente = self->processo_corrente;
+  if (corrente->pid != SEM_PROCESSO && corrente->estado == EXECUCAO) {
+    corrente->epoca_mlfq = self->epoca_mlfq;
+    corrente->nivel = 0;
+    corrente->quantum = self->quantum_mlfq[0];
+  }
+}
+
+// trata o fim de um intervalo do relógio no MLFQ: o processo corrente que
+//   gastou o quantum do seu nível desce um nível e vai para o fim da fila
+static void so_trata_relogio_mlfq(so_t *self)
+{
+  processo_t *proc = self->processo_corrente;
+  if (proc->pid != SEM_PROCESSO && proc->estado == EXECUCAO
+      && proc->quantum <= 0)
+  {
+    if (proc->nivel < N_NIVEIS_MLFQ - 1) proc->nivel++;
+    proc->quantum = self->quantum_mlfq[proc->nivel];
+    proc->estado = PRONTO;
+    fila_proc_insere(&self->processos_prontos[proc->nivel], proc);
+    self->n_preempcoes++;
+    console_log(LOG_DEPURA, "SO: [%d] desce para o nível %d", proc->pid,
+                proc->nivel);
+  }
+  if (--self->t_elevacao_mlfq <= 0)
+  {
+    self->t_elevacao_mlfq = PERIODO_ELEVACAO_MLFQ;
+    so_eleva_processos_mlfq(self);
+  }
+}
+
 // interrupção gerada quando o timer expira
 static void so_trata_irq_relogio(so_t *self)
 {
   // rearma o interruptor do relógio e reinicializa o timer para a próxima interrupção
   err_t e1, e2;
   e1 = es_escreve(self->es, D_RELOGIO_INTERRUPCAO, 0); // desliga o sinalizador de interrupção
-  e2 = es_escreve(self->es, D_RELOGIO_TIMER, INTERVALO_INTERRUPCAO);
+  e2 = es_escreve(self->es, D_RELOGIO_TIMER, self->intervalo_relogio);
   if (e1 != ERR_OK || e2 != ERR_OK) {
-    console_printf("SO: problema da reinicialização do timer");
+    console_log(LOG_ERRO, "SO: problema da reinicialização do timer");
+    self->erro_interno = true;
+  }
+  // registra os acessos às páginas no último intervalo
+  so_atualiza_idade_das_paginas(self);
+  // desconta o intervalo do quantum do processo corrente
+  processo_t *proc = self->processo_corrente;
+  bool executando = proc->pid != SEM_PROCESSO && proc->estado == EXECUCAO;
+  if (executando) proc->quantum--;
+  if (self->escalonador == ESCAL_MLFQ) {
+    so_trata_relogio_mlfq(self);
+  } else if (executando && proc->quantum <= 0
+             && self->escalonador != ESCAL_SIMPLES) {
+    // gastou o quantum: perde a CPU e vai para o fim da fila de prontos
+    //   (o escalonador escolhe o próximo, que pode ser ele de novo)
+    processo_atualiza_prioridade(self, proc);
+    proc->estado = PRONTO;
+    so_insere_pronto(self, proc);
+    self->n_preempcoes++;
+    console_log(LOG_DEPURA, "SO: [%d] gastou o quantum", proc->pid);
+  }
+}
+
+// envia para a tela do terminal os caracteres da saída, enquanto ela estiver livre
+static void so_esvazia_saida(so_t *self, int terminal)
+{
+  saida_terminal_t *saida = &self->saida_terminal[terminal];
+  int base = D_TERM_A + terminal * N_DISP_TERMINAL;
+  while (saida->n > 0) {
+    int livre;
+    if (es_le(self->es, base + TERM_TELA_OK, &livre) != ERR_OK) {
+      console_log(LOG_ERRO, "SO: problema no acesso ao estado da tela");
+      self->erro_interno = true;
+      return;
+    }
+    if (livre == 0) return;
+    if (es_escreve(self->es, base + TERM_TELA, saida->car[saida->prim]) != ERR_OK) {
+      console_log(LOG_ERRO, "SO: problema no acesso à tela");
+      self->erro_interno = true;
+      return;
+    }
+    saida->prim = (saida->prim + 1) % TAM_SAIDA_TERMINAL;
+    saida->n--;
+  }
+}
+
+// atende os processos esperando pelo dispositivo, em ordem, enquanto ele
+//   estiver pronto (ou, para a tela, enquanto couber na saída)
+static void so_atende_dispositivo(so_t *self, int dispositivo)
+{
+  fila_proc_t *espera = &self->espera_dispositivo[dispositivo];
+  while (!fila_proc_vazia(espera)) {
+    processo_t *p = espera->prim;
+    if (!so_tenta_es(self, p, dispositivo)) break;
+    fila_proc_tira(p);
+    processo_desbloqueia(self, p);
+  }
+}
+
+// habilita a interrupção do teclado se tiver processo esperando por ele, e a
+//   da tela se tiver caracteres na saída
+static void so_atualiza_interrupcoes(so_t *self, int dispositivo)
+{
+  int terminal = (dispositivo - D_TERM_A) / N_DISP_TERMINAL;
+  int base = D_TERM_A + terminal * N_DISP_TERMINAL;
+  int interrupcoes = 0;
+  if (!fila_proc_vazia(&self->espera_dispositivo[base + TERM_TECLADO_OK])) {
+    interrupcoes |= TERM_INT_TECLADO;
+  }
+  if (self->saida_terminal[terminal].n > 0) {
+    interrupcoes |= TERM_INT_TELA;
+  }
+  if (interrupcoes == self->interrupcoes_terminal[terminal]) return;
+  if (es_escreve(self->es, D_TERM_A_INTERRUPCAO + terminal, interrupcoes) != ERR_OK) {
+    console_log(LOG_ERRO, "SO: problema na programação das interrupções do terminal");
     self->erro_interno = true;
+    return;
+  }
+  self->interrupcoes_terminal[terminal] = interrupcoes;
+}
+
+// interrupção gerada quando o teclado de algum terminal tem entrada
+//   ('subdispositivo' é TERM_TECLADO_OK) ou a tela está livre (TERM_TELA_OK)
+// a do teclado só é gerada pelos terminais com processos esperando (ver
+//   so_es_ou_bloqueia), a da tela pelos que têm caracteres na saída (ver
+//   so_tenta_escrita); quando não tem mais, a interrupção é desabilitada
+static void so_trata_irq_terminal(so_t *self, int subdispositivo)
+{
+  for (int t = 0; t < N_TERMINAIS; t++) {
+    int dispositivo = D_TERM_A + t * N_DISP_TERMINAL + subdispositivo;
+    if (subdispositivo == TERM_TELA_OK) so_esvazia_saida(self, t);
+    so_atende_dispositivo(self, dispositivo);
+    so_atualiza_interrupcoes(self, dispositivo);
   }
-  // t2: deveria tratar a interrupção
-  //   por exemplo, decrementa o quantum do processo corrente, quando se tem
-  //   um escalonador com quantum
-  console_printf("SO: interrupção do relógio (não tratada)");
 }
 
 // foi gerada uma interrupção para a qual o SO não está preparado
 static void so_trata_irq_desconhecida(so_t *self, int irq)
 {
-  console_printf("SO: não sei tratar IRQ %d (%s)", irq, irq_nome(irq));
+  console_log(LOG_ERRO, "SO: não sei tratar IRQ %d (%s)", irq, irq_nome(irq));
   self->erro_interno = true;
 }
 
@@ -918,16 +1501,18 @@ static void so_trata_irq_desconhecida(so_t *self, int irq)
 // funções auxiliares para cada chamada de sistema
 static void so_chamada_le(so_t *self);
 static void so_chamada_escr(so_t *self);
+static void so_chamada_escr_str(so_t *self);
 static void so_chamada_cria_proc(so_t *self);
 static void so_chamada_mata_proc(so_t *self);
 static void so_chamada_espera_proc(so_t *self);
+static void so_chamada_dorme(so_t *self);
 
 static void so_trata_irq_chamada_sistema(so_t *self)
 {
   // a identificação da chamada está no registrador A
   // t2: com processos, o reg A deve estar no descritor do processo corrente
   int id_chamada = self->regA;
-  console_printf("SO: chamada de sistema %d", id_chamada);
+  console_log(LOG_DEPURA, "SO: chamada de sistema %d", id_chamada);
   switch (id_chamada) {
     case SO_LE:
       so_chamada_le(self);
@@ -935,6 +1520,9 @@ static void so_trata_irq_chamada_sistema(so_t *self)
     case SO_ESCR:
       so_chamada_escr(self);
       break;
+    case SO_ESCR_STR:
+      so_chamada_escr_str(self);
+      break;
     case SO_CRIA_PROC:
       so_chamada_cria_proc(self);
       break;
@@ -944,88 +1532,120 @@ static void so_trata_irq_chamada_sistema(so_t *self)
     case SO_ESPERA_PROC:
       so_chamada_espera_proc(self);
       break;
+    case SO_DORME:
+      so_chamada_dorme(self);
+      break;
     default:
-      console_printf("SO: chamada de sistema desconhecida (%d)", id_chamada);
+      console_log(LOG_ERRO, "SO: chamada de sistema desconhecida (%d)", id_chamada);
       // t2: deveria matar o processo
       self->erro_interno = true;
   }
 }
 
-// implementação da chamada se sistema SO_LE
-// faz a leitura de um dado da entrada corrente do processo, coloca o dado no reg A
-static void so_chamada_le(so_t *self)
+// coloca no fim da saída do terminal o que o processo quer escrever, o
+//   caractere em X (SO_ESCR) ou a string que começa em X (SO_ESCR_STR), e
+//   envia o que puder para a tela; a chamada é identificada pelo reg A
+// retorna false se não couber na saída
+static bool so_tenta_escrita(so_t *self, processo_t *proc, int terminal)
 {
-  // implementação com espera ocupada
-  //   t2: deveria realizar a leitura somente se a entrada estiver disponível,
-  //     senão, deveria bloquear o processo.
-  //   no caso de bloqueio do processo, a leitura (e desbloqueio) deverá
-  //     ser feita mais tarde, em tratamentos pendentes em outra interrupção,
-  //     ou diretamente em uma interrupção específica do dispositivo, se for
-  //     o caso
-  // implementação lendo direto do terminal A
-  //   t2: deveria usar dispositivo de entrada corrente do processo
-  for (;;) {  // espera ocupada!
-    int estado;
-    if (es_le(self->es, D_TERM_A_TECLADO_OK, &estado) != ERR_OK) {
-      console_printf("SO: problema no acesso ao estado do teclado");
-      self->erro_interno = true;
-      return;
+  saida_terminal_t *saida = &self->saida_terminal[terminal];
+  if (proc->regA == SO_ESCR) {
+    if (saida->n == TAM_SAIDA_TERMINAL) return false;
+    saida->car[(saida->prim + saida->n++) % TAM_SAIDA_TERMINAL] = proc->regX;
+  } else {
+    int str[TAM_SAIDA_TERMINAL];
+    int n = so_copia_ate_zero_do_processo(self, proc, proc->regX,
+                                          TAM_SAIDA_TERMINAL, str);
+    if (n == -1) {
+      console_log(LOG_INFO, "SO: [%d] string inválida para escrita", proc->pid);
+      proc->regA = -1;
+      return true;
     }
-    if (estado != 0) break;
-    // como não está saindo do SO, a unidade de controle não está executando seu laço.
-    // esta gambiarra faz pelo menos a console ser atualizada
-    // t2: com a implementação de bloqueio de processo, esta gambiarra não
-    //   deve mais existir.
-    console_tictac(self->console);
+    if (saida->n + n > TAM_SAIDA_TERMINAL) return false;
+    for (int i = 0; i < n; i++) {
+      saida->car[(saida->prim + saida->n++) % TAM_SAIDA_TERMINAL] = str[i];
+    }
+  }
+  proc->regA = 0;
+  so_esvazia_saida(self, terminal);
+  return true;
+}
+
+// realiza a E/S do processo no dispositivo (o de estado do teclado ou da tela
+//   de um terminal), se ele estiver pronto: a leitura coloca o dado lido no
+//   reg A do processo, a escrita vai para a saída do terminal (ver
+//   so_tenta_escrita)
+// retorna false se o dispositivo não estiver pronto ou a saída estiver cheia
+static bool so_tenta_es(so_t *self, processo_t *proc, int dispositivo)
+{
+  int terminal = (dispositivo - D_TERM_A) / N_DISP_TERMINAL;
+  if ((dispositivo - D_TERM_A) % N_DISP_TERMINAL == TERM_TELA_OK) {
+    return so_tenta_escrita(self, proc, terminal);
+  }
+  int pronto;
+  if (es_le(self->es, dispositivo, &pronto) != ERR_OK) {
+    console_log(LOG_ERRO, "SO: problema no acesso ao estado do dispositivo %d",
+                dispositivo);
+    self->erro_interno = true;
+    return false;
   }
+  if (pronto == 0) return false;
   int dado;
-  if (es_le(self->es, D_TERM_A_TECLADO, &dado) != ERR_OK) {
-    console_printf("SO: problema no acesso ao teclado");
+  if (es_le(self->es, D_TERM_A + terminal * N_DISP_TERMINAL + TERM_TECLADO,
+            &dado) != ERR_OK) {
+    console_log(LOG_ERRO, "SO: problema no acesso ao teclado");
     self->erro_interno = true;
-    return;
+    return false;
   }
-  // escreve no reg A do processador
-  // (na verdade, na posição onde o processador vai pegar o A quando retornar da int)
-  // t2: se houvesse processo, deveria escrever no reg A do processo
-  // t2: o acesso só deve ser feito nesse momento se for possível; se não, o processo
-  //   é bloqueado, e o acesso só deve ser feito mais tarde (e o processo desbloqueado)
-  self->regA = dado;
+  proc->regA = dado;
+  return true;
+}
+
+// realiza a E/S do processo corrente, se o dispositivo estiver pronto e não
+//   tiver outro processo esperando por ele; senão, bloqueia o processo no fim
+//   da fila do dispositivo, e a E/S é feita no tratamento da interrupção do
+//   terminal, quando chegar a vez dele
+static void so_es_ou_bloqueia(so_t *self, int dispositivo)
+{
+  processo_t *proc = self->processo_corrente;
+  fila_proc_t *espera = &self->espera_dispositivo[dispositivo];
+  if (!fila_proc_vazia(espera) || !so_tenta_es(self, proc, dispositivo)) {
+    if (self->erro_interno) return;
+    proc->estado = BLOQUEADO;
+    proc->dispositivo_causou_bloqueio = dispositivo;
+    processo_atualiza_prioridade(self, proc);
+    fila_proc_insere(espera, proc);
+  }
+  // a interrupção do teclado é habilitada se o processo bloqueou, a da tela se
+  //   ficou algo na saída
+  so_atualiza_interrupcoes(self, dispositivo);
+}
+
+// implementação da chamada se sistema SO_LE
+// faz a leitura de um dado da entrada corrente do processo, coloca o dado no reg A
+static void so_chamada_le(so_t *self)
+{
+  // implementação lendo direto do terminal A
+  //   t2: deveria usar dispositivo de entrada corrente do processo
+  so_es_ou_bloqueia(self, D_TERM_A_TECLADO_OK);
 }
 
 // implementação da chamada se sistema SO_ESCR
 // escreve o valor do reg X na saída corrente do processo
 static void so_chamada_escr(so_t *self)
 {
-  // implementação com espera ocupada
-  //   t2: deveria bloquear o processo se dispositivo ocupado
   // implementação escrevendo direto do terminal A
   //   t2: deveria usar o dispositivo de saída corrente do processo
-  for (;;) {
-    int estado;
-    if (es_le(self->es, D_TERM_A_TELA_OK, &estado) != ERR_OK) {
-      console_printf("SO: problema no acesso ao estado da tela");
-      self->erro_interno = true;
-      return;
-    }
-    if (estado != 0) break;
-    // como não está saindo do SO, a unidade de controle não está executando seu laço.
-    // esta gambiarra faz pelo menos a console ser atualizada
-    // t2: não deve mais existir quando houver suporte a processos, porque o SO não poderá
-    //   executar por muito tempo, permitindo a execução do laço da unidade de controle
-    console_tictac(self->console);
-  }
-  int dado;
-  // está lendo o valor de X e escrevendo o de A direto onde o processador colocou/vai pegar
-  // t2: deveria usar os registradores do processo que está realizando a E/S
-  // t2: caso o processo tenha sido bloqueado, esse acesso deve ser realizado em outra execução
-  //   do SO, quando ele verificar que esse acesso já pode ser feito.
-  dado = self->regX;
-  if (es_escreve(self->es, D_TERM_A_TELA, dado) != ERR_OK) {
-    console_printf("SO: problema no acesso à tela");
-    self->erro_interno = true;
-    return;
-  }
-  self->regA = 0;
+  so_es_ou_bloqueia(self, D_TERM_A_TELA_OK);
+}
+
+// implementação da chamada se sistema SO_ESCR_STR
+// escreve a string que começa no endereço X na saída corrente do processo
+static void so_chamada_escr_str(so_t *self)
+{
+  // a string vai para a saída do terminal de uma vez, com os caracteres
+  //   escritos por SO_ESCR, na ordem das chamadas
+  so_es_ou_bloqueia(self, D_TERM_A_TELA_OK);
 }
 
 // implementação da chamada se sistema SO_CRIA_PROC
@@ -1047,9 +1667,7 @@ static void so_chamada_cria_proc(so_t *self)
   if (so_copia_str_do_processo(self, 100, nome, ender_proc, *self->processo_corrente)) {
     int ender_carga = -1;
     pid = processo_cria(self, nome, &ender_carga);
-    // usado aqui para não gerar warning
-    int indice_proc_criado = acha_indice_por_pid(self, pid);
-    console_printf("indice proc criado: %d\n", indice_proc_criado);
+    console_log(LOG_DEPURA, "pid do proc criado: %d\n", pid);
 
     
     if (ender_carga != -1) {
@@ -1095,24 +1713,556 @@ static void so_chamada_espera_proc(so_t *self)
   self->regA = -1;
   */
 
-  // verifica se o processo a se esperar é válido
-  if (self->processo_corrente->regX == self->processo_corrente->pid || 
-    !processo_existe(self, self->processo_corrente->regX))
+  // verifica se o processo a se esperar é válido; se não for, retorna erro
+  //   sem bloquear (o processo pode já ter morrido)
+  processo_t *esperado = acha_processo_por_pid(self, self->processo_corrente->regX);
+  if (esperado == NULL || esperado == self->processo_corrente)
   {
-    console_printf("-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-");
-    console_printf("PROCESSO INVÁLIDO");
-    console_printf("-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-");
-    self->erro_interno = true;
+    console_log(LOG_INFO, "SO: [%d] não pode esperar o fim de [%d]",
+                self->processo_corrente->pid, self->processo_corrente->regX);
+    self->processo_corrente->regA = -1;
     return;
   }
 
-  console_printf("[%d] vai esperar o fim de [%d]", self->processo_corrente->pid, self->processo_corrente->regX);
+  console_log(LOG_DEPURA, "[%d] vai esperar o fim de [%d]", self->processo_corrente->pid, self->processo_corrente->regX);
 
-  // bloqueia o processo chamador
+  // bloqueia o processo chamador, que é desbloqueado na morte do esperado
   self->processo_corrente->estado = BLOQUEADO;
-  processo_atualiza_prioridade(self->processo_corrente);
-  fila_deque(self->processos_prontos);
-  self->processo_corrente->pid_esperando = self->processo_corrente->regX;
+  self->processo_corrente->regA = 0;
+  processo_atualiza_prioridade(self, self->processo_corrente);
+  self->processo_corrente->pid_esperando = esperado->pid;
+  self->processo_corrente->prox_esperando = esperado->esperando;
+  esperado->esperando = self->processo_corrente;
+}
+
+// implementação da chamada se sistema SO_DORME
+// bloqueia o processo corrente por X instruções
+static void so_chamada_dorme(so_t *self)
+{
+  processo_t *proc = self->processo_corrente;
+  proc->regA = 0;
+  if (proc->regX <= 0) return;
+  int agora;
+  if (es_le(self->es, D_RELOGIO_INSTRUCOES, &agora) != ERR_OK) {
+    console_log(LOG_ERRO, "SO: problema no acesso ao relógio");
+    self->erro_interno = true;
+    return;
+  }
+  // o processo é acordado nas pendências da primeira interrupção depois da data
+  proc->estado = BLOQUEADO;
+  proc->data_desbloqueio = agora + proc->regX;
+  processo_atualiza_prioridade(self, proc);
+  alarmes_insere(self->alarmes, proc->data_desbloqueio, proc->pid);
+}
+
+
+// ---------------------------------------------------------------------
+// PAGINAÇÃO {{{1
+// ---------------------------------------------------------------------
+
+// Cada página de um processo tem um lugar na memória secundária (em
+//   quadros_mem2): no início, o bloco da imagem do programa, compartilhado com
+//   os outros processos que executam o mesmo programa. Uma página é trazida
+//   para um quadro da memória principal quando ocorre uma falta; se não tiver
+//   quadro livre, o algoritmo de substituição escolhe uma vítima entre os
+//   quadros ocupados por processos. A vítima só é copiada de volta para a
+//   memória secundária se tiver sido alterada; na primeira vez, para um bloco
+//   novo, só do processo (cópia na escrita).
+
+char *so_nome_substituicao(so_substituicao_t alg)
+{
+  switch (alg) {
+    case SUBST_FIFO:           return "fifo";
+    case SUBST_SEGUNDA_CHANCE: return "segunda_chance";
+    case SUBST_LRU:            return "lru";
+    case SUBST_NRU:            return "nru";
+    default:                   return "???";
+  }
+}
+
+void so_define_substituicao(so_t *self, so_substituicao_t alg)
+{
+  assert(alg >= 0 && alg < N_SUBST);
+  self->substituicao = alg;
+}
+
+void so_estatisticas_paginacao(so_t *self, long *pfaltas,
+                               long *psubstituicoes, long *pescritas)
+{
+  *pfaltas = self->n_faltas;
+  *psubstituicoes = self->n_substituicoes;
+  *pescritas = self->n_escritas_mem2;
+}
+
+// retorna o processo que ocupa o quadro, ou NULL se o quadro estiver livre
+//   ou não puder ser substituído
+static processo_t *so_dono_do_quadro(so_t *self, int quadro)
+{
+  if (self->tabquadros[quadro].em_transferencia) return NULL;
+  if (self->tabquadros[quadro].nova) return NULL;
+  return so_processo_do_dono(self, quadros_dono(self->quadros_mem, quadro));
+}
+
+// zera o bit de acesso de uma página
+// se a tabela do processo está na MMU, a entrada na TLB tem que ser invalidada,
+//   para que o próximo acesso marque o bit de novo
+static void so_zera_bit_acesso(so_t *self, processo_t *dono, int pagina)
+{
+  tabpag_zera_bit_acesso(dono->tabpag, pagina);
+  if (dono == self->processo_corrente) mmu_invalida_pagina(self->mmu, pagina);
+}
+
+// endereço na memória secundária onde fica a página de um processo
+// retorna -1 se a página não faz parte do programa do processo
+static int so_end_mem2_da_pagina(so_t *self, processo_t *proc,
+                                 int pagina)
+{
+  if (pagina < 0 || pagina >= proc->n_paginas) return -1;
+  return proc->quadros_mem2[pagina] * self->tam_pagina;
+}
+
+// tira o quadro da lista na ordem de carga (se estiver nela)
+static void so_tira_da_ordem_de_carga(so_t *self, int quadro)
+{
+  quadro_t *q = &self->tabquadros[quadro];
+  if (!q->na_ordem_de_carga) return;
+  if (q->ant_carga == -1) self->prim_carga = q->prox_carga;
+  else self->tabquadros[q->ant_carga].prox_carga = q->prox_carga;
+  if (q->prox_carga == -1) self->ult_carga = q->ant_carga;
+  else self->tabquadros[q->prox_carga].ant_carga = q->ant_carga;
+  q->na_ordem_de_carga = false;
+}
+
+// registra uma carga no quadro: ele passa a ser o último na ordem de carga
+static void so_registra_carga(so_t *self, int quadro)
+{
+  so_tira_da_ordem_de_carga(self, quadro);
+  quadro_t *q = &self->tabquadros[quadro];
+  q->carga = ++self->n_cargas;
+  q->ant_carga = self->ult_carga;
+  q->prox_carga = -1;
+  if (self->ult_carga == -1) self->prim_carga = quadro;
+  else self->tabquadros[self->ult_carga].prox_carga = quadro;
+  self->ult_carga = quadro;
+  q->na_ordem_de_carga = true;
+}
+
+// FIFO e segunda chance: percorre os quadros na ordem de carga até achar um
+//   que possa ser substituído; sem percorrer a memória toda, porque os que
+//   não podem (em transferência ou com páginas novas) são poucos e recentes
+// na segunda chance, um quadro com a página acessada tem o bit de acesso
+//   zerado e vai para o fim da lista em vez de ser escolhido
+// retorna -1 se nenhum quadro pode ser substituído
+static int so_vitima_na_ordem_de_carga(so_t *self, bool segunda_chance)
+{
+  int quadro = self->prim_carga;
+  while (quadro != -1) {
+    int prox = self->tabquadros[quadro].prox_carga;
+    processo_t *dono = so_dono_do_quadro(self, quadro);
+    if (dono != NULL) {
+      int pagina = self->tabquadros[quadro].pagina;
+      if (!segunda_chance || !tabpag_bit_acesso(dono->tabpag, pagina)) {
+        return quadro;
+      }
+      so_zera_bit_acesso(self, dono, pagina);
+      so_registra_carga(self, quadro);
+      // se era o último, os poupados antes dele estão depois dos que não
+      //   podem ser substituídos, recomeça do início
+      if (prox == -1) prox = self->prim_carga;
+    }
+    quadro = prox;
+  }
+  return -1;
+}
+
+// LRU aproximado e NRU: escolhe o quadro com a menor classe e, entre esses, o
+//   ocupado há mais tempo (menor carga)
+// percorre todos os quadros, porque a classe de cada um muda a cada
+//   interrupção do relógio
+static int so_quadro_mais_antigo(so_t *self, int classe(so_t *, int))
+{
+  int escolhido = -1;
+  int menor_classe = 0;
+  for (int quadro = 0; quadro < quadros_n_quadros(self->quadros_mem); quadro++) {
+    if (so_dono_do_quadro(self, quadro) == NULL) continue;
+    int cl = classe(self, quadro);
+    if (escolhido == -1 || cl < menor_classe
+        || (cl == menor_classe
+            && self->tabquadros[quadro].carga < self->tabquadros[escolhido].carga)) {
+      escolhido = quadro;
+      menor_classe = cl;
+    }
+  }
+  return escolhido;
+}
+
+// classe para o LRU aproximado: a idade (menor é usada há mais tempo)
+static int so_classe_lru(so_t *self, int quadro)
+{
+  return self->tabquadros[quadro].idade;
+}
+
+// classe para o NRU: 0 não acessada nem alterada, 1 alterada, 2 acessada,
+//   3 acessada e alterada
+static int so_classe_nru(so_t *self, int quadro)
+{
+  processo_t *dono = so_dono_do_quadro(self, quadro);
+  int pagina = self->tabquadros[quadro].pagina;
+  return tabpag_bit_acesso(dono->tabpag, pagina) * 2
+         + tabpag_bit_alteracao(dono->tabpag, pagina);
+}
+
+// escolhe o quadro a ser liberado, conforme o algoritmo de substituição
+// retorna -1 se nenhum quadro pode ser liberado
+static int so_aplica_substituicao(so_t *self)
+{
+  switch (self->substituicao) {
+    case SUBST_SEGUNDA_CHANCE:
+      return so_vitima_na_ordem_de_carga(self, true);
+    case SUBST_LRU:
+      return so_quadro_mais_antigo(self, so_classe_lru);
+    case SUBST_NRU:
+      return so_quadro_mais_antigo(self, so_classe_nru);
+    case SUBST_FIFO:
+    default:
+      return so_vitima_na_ordem_de_carga(self, false);
+  }
+}
+
+// As páginas que chegam do disco ficam protegidas da substituição até que o
+//   dono progrida (seja interrompido fora da instrução que causou a falta).
+//   Sem isso, um processo que precisa de várias páginas para executar uma
+//   instrução pode perdê-las para as faltas dos outros enquanto espera as
+//   seguintes, e nenhum progride.
+
+// desprotege as páginas novas do processo
+static void so_desprotege_paginas_do_processo(so_t *self, processo_t *proc)
+{
+  if (proc->pid == SEM_PROCESSO) return;
+  for (int quadro = quadros_primeiro_do_dono(self->quadros_mem, so_dono(proc));
+       quadro != -1; quadro = quadros_proximo(self->quadros_mem, quadro)) {
+    self->tabquadros[quadro].nova = false;
+  }
+}
+
+// desprotege as páginas novas de todos os processos, menos as do dono da
+//   página nova mais antiga, para que pelo menos ele consiga progredir; se só
+//   ele tiver páginas novas, desprotege as dele
+// retorna true se alguma página foi desprotegida
+static bool so_desprotege_paginas_novas(so_t *self)
+{
+  int n_quadros = quadros_n_quadros(self->quadros_mem);
+  int mais_antiga = -1;
+  for (int quadro = 0; quadro < n_quadros; quadro++) {
+    if (!self->tabquadros[quadro].nova) continue;
+    if (mais_antiga == -1
+        || self->tabquadros[quadro].carga < self->tabquadros[mais_antiga].carga) {
+      mais_antiga = quadro;
+    }
+  }
+  if (mais_antiga == -1) return false;
+  int privilegiado = quadros_dono(self->quadros_mem, mais_antiga);
+  bool alguma = false;
+  for (int quadro = 0; quadro < n_quadros; quadro++) {
+    if (self->tabquadros[quadro].nova
+        && quadros_dono(self->quadros_mem, quadro) != privilegiado) {
+      self->tabquadros[quadro].nova = false;
+      alguma = true;
+    }
+  }
+  if (!alguma) {
+    for (int quadro = quadros_primeiro_do_dono(self->quadros_mem, privilegiado);
+         quadro != -1; quadro = quadros_proximo(self->quadros_mem, quadro)) {
+      self->tabquadros[quadro].nova = false;
+    }
+  }
+  return true;
+}
+
+// escolhe o quadro a ser liberado; se todos estiverem protegidos, desfaz
+//   parte das proteções das páginas novas
+// retorna -1 se nenhum quadro pode ser liberado
+static int so_escolhe_vitima(so_t *self)
+{
+  int quadro = so_aplica_substituicao(self);
+  while (quadro == -1 && so_desprotege_paginas_novas(self)) {
+    quadro = so_aplica_substituicao(self);
+  }
+  return quadro;
+}
+
+// a cada interrupção do relógio, os algoritmos que dependem do uso recente
+//   das páginas registram os bits de acesso e zeram esses bits
+// só as páginas do processo que estava executando envelhecem (o tempo conta
+//   para cada processo só quando ele executa); senão as páginas de um processo
+//   esperando o disco ficariam velhas e seriam substituídas antes que ele
+//   voltasse a executar
+static void so_atualiza_idade_das_paginas(so_t *self)
+{
+  if (self->substituicao != SUBST_LRU && self->substituicao != SUBST_NRU) return;
+  processo_t *proc = self->processo_corrente;
+  if (proc->pid == SEM_PROCESSO || proc->estado != EXECUCAO) return;
+  for (int quadro = quadros_primeiro_do_dono(self->quadros_mem, so_dono(proc));
+       quadro != -1; quadro = quadros_proximo(self->quadros_mem, quadro)) {
+    if (self->tabquadros[quadro].em_transferencia) continue;
+    quadro_t *q = &self->tabquadros[quadro];
+    bool acessada = tabpag_bit_acesso(proc->tabpag, q->pagina);
+    q->idade = (q->idade >> 1) | (acessada ? 0x80 : 0);
+    if (acessada) so_zera_bit_acesso(self, proc, q->pagina);
+  }
+}
+
+// faz um pedido de transferência ao disco, e o registra na fila de pedidos
+//   do SO, para tratar a conclusão (os pedidos são concluídos em ordem)
+static void so_pede_transferencia(so_t *self, int comando, int pid, int pagina,
+                                  int quadro, int bloco)
+{
+  if (es_escreve(self->es, D_DISCO_QUADRO, quadro) != ERR_OK
+      || es_escreve(self->es, D_DISCO_BLOCO, bloco) != ERR_OK
+      || es_escreve(self->es, D_DISCO_COMANDO, comando) != ERR_OK) {
+    console_log(LOG_ERRO, "SO: erro no pedido ao disco (quadro %d, bloco %d)",
+                quadro, bloco);
+    self->erro_interno = true;
+    return;
+  }
+  if (self->n_pedidos_disco == self->cap_pedidos_disco) {
+    // aumenta a fila, desfazendo a volta
+    int cap = self->cap_pedidos_disco * 2;
+    pedido_disco_t *pedidos = malloc(cap * sizeof(pedido_disco_t));
+    assert(pedidos != NULL);
+    for (int i = 0; i < self->n_pedidos_disco; i++) {
+      pedidos[i] = self->pedidos_disco[(self->prim_pedido_disco + i)
+                                       % self->cap_pedidos_disco];
+    }
+    free(self->pedidos_disco);
+    self->pedidos_disco = pedidos;
+    self->cap_pedidos_disco = cap;
+    self->prim_pedido_disco = 0;
+  }
+  int pos = (self->prim_pedido_disco + self->n_pedidos_disco) % self->cap_pedidos_disco;
+  self->pedidos_disco[pos] = (pedido_disco_t){ comando, pid, pagina, quadro, bloco };
+  self->n_pedidos_disco++;
+}
+
+// retorna o i-ésimo pedido ao disco ainda não concluído
+static pedido_disco_t *so_pedido_disco(so_t *self, int i)
+{
+  return &self->pedidos_disco[(self->prim_pedido_disco + i) % self->cap_pedidos_disco];
+}
+
+// retorna o bloco da memória secundária onde a página alterada de um processo
+//   deve ser escrita: se a página ainda está no bloco da imagem do programa,
+//   aloca um bloco só para o processo, que passa a ser o lugar da página
+// retorna -1 se não houver bloco livre
+static int so_bloco_privado(so_t *self, processo_t *proc, int pagina)
+{
+  int bloco = proc->quadros_mem2[pagina];
+  if (quadros_dono(self->quadros_mem2, bloco) != BLOCO_IMAGEM) return bloco;
+  bloco = quadros_aloca(self->quadros_mem2, so_dono(proc));
+  if (bloco == -1 && so_libera_imagens_sem_uso(self)) {
+    bloco = quadros_aloca(self->quadros_mem2, so_dono(proc));
+  }
+  if (bloco == -1) return -1;
+  console_log(LOG_DEPURA, "SO: página %d do processo %d copiada da imagem para "
+              "o bloco %d", pagina, proc->pid, bloco);
+  proc->quadros_mem2[pagina] = bloco;
+  return bloco;
+}
+
+// retira a página que está no quadro da memória principal, pedindo ao disco
+//   para copiá-la para a memória secundária se ela tiver sido alterada
+// o quadro pode ser usado para trazer outra página logo em seguida: como o
+//   disco atende os pedidos em ordem, a cópia é feita antes
+static void so_libera_quadro(so_t *self, int quadro)
+{
+  processo_t *dono = so_dono_do_quadro(self, quadro);
+  quadro_t *q = &self->tabquadros[quadro];
+  bool alterada = tabpag_bit_alteracao(dono->tabpag, q->pagina);
+  if (alterada) {
+    int bloco = so_bloco_privado(self, dono, q->pagina);
+    if (bloco == -1) {
+      console_log(LOG_ERRO, "SO: memória secundária cheia, página %d do "
+                  "processo %d perdida", q->pagina, dono->pid);
+      self->erro_interno = true;
+    } else {
+      so_pede_transferencia(self, DISCO_ESCREVE, dono->pid, q->pagina, quadro,
+                            bloco);
+      self->n_escritas_mem2++;
+    }
+  }
+  console_log(LOG_DEPURA, "SO: quadro %d liberado (pid %d, página %d%s)", quadro,
+              dono->pid, q->pagina, alterada ? ", copiada para mem2" : "");
+  tabpag_invalida_pagina(dono->tabpag, q->pagina);
+  if (dono == self->processo_corrente) mmu_invalida_pagina(self->mmu, q->pagina);
+  quadros_libera(self->quadros_mem, quadro);
+  so_tira_da_ordem_de_carga(self, quadro);
+  q->pagina = -1;
+}
+
+static void so_libera_memoria_do_processo(so_t *self, processo_t *proc)
+{
+  // os pedidos ao disco pendentes do processo não devem mais alterar o estado
+  //   do SO quando concluídos; os blocos que ainda vão ser escritos só são
+  //   liberados depois, para não serem reusados antes da escrita
+  for (int i = 0; i < self->n_pedidos_disco; i++) {
+    pedido_disco_t *pedido = so_pedido_disco(self, i);
+    if (pedido->pid != proc->pid) continue;
+    pedido->pid = SEM_PROCESSO;
+    if (pedido->comando == DISCO_ESCREVE
+        && quadros_dono(self->quadros_mem2, pedido->bloco) == so_dono(proc)) {
+      quadros_libera(self->quadros_mem2, pedido->bloco);
+      quadros_reserva(self->quadros_mem2, pedido->bloco, BLOCO_PENDENTE);
+    }
+  }
+  for (int quadro = quadros_primeiro_do_dono(self->quadros_mem, so_dono(proc));
+       quadro != -1; quadro = quadros_proximo(self->quadros_mem, quadro)) {
+    self->tabquadros[quadro].pagina = -1;
+    self->tabquadros[quadro].em_transferencia = false;
+    self->tabquadros[quadro].nova = false;
+    so_tira_da_ordem_de_carga(self, quadro);
+  }
+  quadros_libera_do_dono(self->quadros_mem, so_dono(proc));
+  quadros_libera_do_dono(self->quadros_mem2, so_dono(proc));
+  free(proc->quadros_mem2);
+  proc->quadros_mem2 = NULL;
+  proc->n_paginas = 0;
+  // a imagem continua carregada, para os próximos processos com o programa
+  if (proc->imagem != NULL) proc->imagem->n_refs--;
+  proc->imagem = NULL;
+}
+
+// retorna true se algum pedido ainda não concluído vai escrever no bloco
+static bool so_bloco_tem_escrita_pendente(so_t *self, int bloco)
+{
+  for (int i = 0; i < self->n_pedidos_disco; i++) {
+    pedido_disco_t *pedido = so_pedido_disco(self, i);
+    if (pedido->comando == DISCO_ESCREVE && pedido->bloco == bloco) return true;
+  }
+  return false;
+}
+
+// lê 'n' valores de uma página de um processo que não está na memória
+//   principal, a partir de 'end_virt' (sem passar do fim da página): da memória
+//   secundária ou, se a página ainda vai ser escrita pelo disco, do quadro de
+//   onde ela vai ser copiada (que só vai ser reusado depois)
+static err_t so_le_pagina_ausente(so_t *self, processo_t *proc, int end_virt,
+                                  int n, int valores[n])
+{
+  int pagina = end_virt / self->tam_pagina;
+  int desl = end_virt % self->tam_pagina;
+  int end_mem2 = so_end_mem2_da_pagina(self, proc, pagina);
+  if (end_mem2 == -1) return ERR_END_INV;
+  // vale a última escrita pedida para a página
+  for (int i = self->n_pedidos_disco - 1; i >= 0; i--) {
+    pedido_disco_t *pedido = so_pedido_disco(self, i);
+    if (pedido->comando == DISCO_ESCREVE && pedido->pid == proc->pid
+        && pedido->pagina == pagina) {
+      return mem_le_bloco(self->mem, pedido->quadro * self->tam_pagina + desl, n,
+                          valores);
+    }
+  }
+  return mem_le_bloco(self->mem2, end_mem2 + desl, n, valores);
+}
+
+// trata a conclusão do primeiro pedido feito ao disco
+static void so_conclui_pedido_disco(so_t *self)
+{
+  if (self->n_pedidos_disco == 0) {
+    console_log(LOG_ERRO, "SO: o disco concluiu um pedido não feito");
+    self->erro_interno = true;
+    return;
+  }
+  pedido_disco_t pedido = *so_pedido_disco(self, 0);
+  self->prim_pedido_disco = (self->prim_pedido_disco + 1) % self->cap_pedidos_disco;
+  self->n_pedidos_disco--;
+
+  if (pedido.pid == SEM_PROCESSO) {
+    // o dono morreu; libera o bloco que estava esperando a escrita
+    if (pedido.comando == DISCO_ESCREVE
+        && quadros_dono(self->quadros_mem2, pedido.bloco) == BLOCO_PENDENTE
+        && !so_bloco_tem_escrita_pendente(self, pedido.bloco)) {
+      quadros_libera(self->quadros_mem2, pedido.bloco);
+    }
+    return;
+  }
+  if (pedido.comando == DISCO_ESCREVE) return;
+
+  // a página chegou: mapeia na tabela do processo e desbloqueia o processo
+  processo_t *proc = acha_processo_por_pid(self, pedido.pid);
+  self->tabquadros[pedido.quadro].em_transferencia = false;
+  self->tabquadros[pedido.quadro].nova = true;
+  console_log(LOG_DEPURA, "SUBSTITUIU QUADRO %d (mem) por %d (mem2)", pedido.quadro,
+              pedido.pagina);
+  tabpag_define_quadro(proc->tabpag, pedido.pagina, pedido.quadro);
+  // a página é marcada como acessada, porque o processo vai acessá-la assim que
+  //   executar; senão ela seria a preferida para substituição por quem usa o
+  //   bit de acesso, e poderia sair antes disso
+  tabpag_marca_bit_acesso(proc->tabpag, pedido.pagina, false);
+  if (proc == self->processo_corrente) mmu_invalida_pagina(self->mmu, pedido.pagina);
+  processo_desbloqueia(self, proc);
+}
+
+// interrupção gerada quando o disco conclui transferências
+static void so_trata_irq_disco(so_t *self)
+{
+  int concluidos;
+  if (es_le(self->es, D_DISCO_CONCLUIDOS, &concluidos) != ERR_OK
+      || es_escreve(self->es, D_DISCO_CONCLUIDOS, 0) != ERR_OK) {
+    console_log(LOG_ERRO, "SO: problema no acesso ao disco");
+    self->erro_interno = true;
+    return;
+  }
+  for (int i = 0; i < concluidos; i++) {
+    so_conclui_pedido_disco(self);
+  }
+}
+
+// pede ao disco a página que contém o endereço que causou a falta, para o
+//   quadro (já alocado para o processo corrente), e bloqueia o processo até a
+//   transferência terminar (ver so_trata_irq_disco)
+static void so_trata_falta_de_pagina(so_t *self)
+{
+  self->n_faltas++;
+  processo_t *proc = self->processo_corrente;
+  char pc[40];
+  simbolos_descreve(proc->simbolos, proc->regPC, pc, sizeof(pc));
+  console_log(LOG_DEPURA, "FALTA DE PAGINA: pid%d end%d, em %s",
+              proc->pid, proc->regComplemento, pc);
+  int pagina = proc->regComplemento / self->tam_pagina;
+  if (so_end_mem2_da_pagina(self, proc, pagina) == -1) {
+    console_log(LOG_ERRO, "SO: página %d fora do programa do processo %d",
+                pagina, proc->pid);
+    self->erro_interno = true;
+    return;
+  }
+  int quadro = quadros_aloca(self->quadros_mem, so_dono(proc));
+  if (quadro == -1) {
+    quadro = so_escolhe_vitima(self);
+    if (quadro == -1) {
+      console_log(LOG_ERRO, "SO: não há quadro que possa ser substituído");
+      self->erro_interno = true;
+      return;
+    }
+    console_log(LOG_DEPURA, "SUBSTITUIÇÃO DE PÁGINA (%s): quadro %d",
+                so_nome_substituicao(self->substituicao), quadro);
+    self->n_substituicoes++;
+    so_libera_quadro(self, quadro);
+    quadros_reserva(self->quadros_mem, quadro, so_dono(proc));
+  }
+  quadro_t *q = &self->tabquadros[quadro];
+  q->pagina = pagina;
+  q->em_transferencia = true;
+  so_registra_carga(self, quadro);
+  q->idade = 0xff;  // a página vai ser acessada quando chegar, conta como recente
+  so_pede_transferencia(self, DISCO_LE, proc->pid, pagina, quadro,
+                        proc->quadros_mem2[pagina]);
+
+  proc->pc_falta = proc->regPC;
+  proc->estado = BLOQUEADO;
+  proc->dispositivo_causou_bloqueio = D_DISCO;
+  // quando voltar a executar, o processo repete a instrução que causou a
+  //   falta, sem erro
+  proc->regERRO = ERR_OK;
 }
 
 
@@ -1123,8 +2273,8 @@ static void so_chamada_espera_proc(so_t *self)
 // funções auxiliares
 static int so_carrega_programa_na_memoria_fisica(so_t *self, programa_t *programa);
 static int so_carrega_programa_na_memoria_virtual(so_t *self,
-                                                  programa_t *programa,
-                                                  processo_t *processo);
+                                                  processo_t *processo,
+                                                  char *nome_do_executavel);
 
 // carrega o programa na memória
 // se processo for NENHUM_PROCESSO, carrega o programa na memória física
@@ -1133,20 +2283,22 @@ static int so_carrega_programa_na_memoria_virtual(so_t *self,
 static int so_carrega_programa(so_t *self, processo_t *processo,
                                char *nome_do_executavel)
 {
-  console_printf("SO: carga de '%s'", nome_do_executavel);
+  console_log(LOG_INFO, "SO: carga de '%s'", nome_do_executavel);
+
+  // o programa de um processo vem da imagem, que só é lida do arquivo na
+  //   primeira vez
+  if (processo->pid != SEM_PROCESSO) {
+    return so_carrega_programa_na_memoria_virtual(self, processo,
+                                                  nome_do_executavel);
+  }
 
   programa_t *programa = prog_cria(nome_do_executavel);
   if (programa == NULL) {
-    console_printf("Erro na leitura do programa '%s'\n", nome_do_executavel);
+    console_log(LOG_ERRO, "Erro na leitura do programa '%s'\n", nome_do_executavel);
     return -1;
   }
 
-  int end_carga;
-  if (processo->pid == SEM_PROCESSO  ) {
-    end_carga = so_carrega_programa_na_memoria_fisica(self, programa);
-  } else {
-    end_carga = so_carrega_programa_na_memoria_virtual(self, programa, processo);
-  }
+  int end_carga = so_carrega_programa_na_memoria_fisica(self, programa);
 
   prog_destroi(programa);
   return end_carga;
@@ -1157,59 +2309,148 @@ static int so_carrega_programa_na_memoria_fisica(so_t *self, programa_t *program
   int end_ini = prog_end_carga(programa);
   int end_fim = end_ini + prog_tamanho(programa);
 
-  for (int end = end_ini; end < end_fim; end++) {
-    if (mem_escreve(self->mem, end, prog_dado(programa, end)) != ERR_OK) {
-      console_printf("Erro na carga da memória, endereco %d\n", end);
-      return -1;
-    }
+  if (mem_escreve_bloco(self->mem, end_ini, prog_tamanho(programa),
+                        prog_dados(programa)) != ERR_OK) {
+    console_log(LOG_ERRO, "Erro na carga da memória, endereços %d-%d\n",
+                end_ini, end_fim);
+    return -1;
   }
 
-  console_printf("SO: carga na memória física %d-%d", end_ini, end_fim);
+  console_log(LOG_DEPURA, "SO: carga na memória física %d-%d", end_ini, end_fim);
   return end_ini;
 }
 
-static int so_carrega_programa_na_memoria_virtual(so_t *self,
-                                                  programa_t *programa,
-                                                  processo_t *processo)
-{
-  // t3: isto tá furado...
-  // está simplesmente lendo para o próximo quadro que nunca foi ocupado,
-  //   nem testa se tem memória disponível
-  // com memória virtual, a forma mais simples de implementar a carga de um
-  //   programa é carregá-lo para a memória secundária, e mapear todas as páginas
-  //   da tabela de páginas do processo como inválidas. Assim, as páginas serão
-  //   colocadas na memória principal por demanda. Para simplificar ainda mais, a
-  //   memória secundária pode ser alocada da forma como a principal está sendo
-  //   alocada aqui (sem reuso)
-
-  // calcula o tamanho de páginas necessárias para o programa
-  int end_virt_ini = 0;
-  int end_virt_fim = prog_tamanho(programa) - 1;
-  int pagina_ini = end_virt_ini / TAM_PAGINA;
-  int pagina_fim = end_virt_fim / TAM_PAGINA;
-  int n_paginas = pagina_fim - pagina_ini + 1;
-  int quadro_ini = self->quadro_livre_mem2;
-  int quadro_fim = quadro_ini + n_paginas - 1;
-
-  // carrega o programa na memória secundária
-  int end_fis_ini = quadro_ini * TAM_PAGINA;
-  int end_fis = end_fis_ini;
-  for (int end_virt = end_virt_ini; end_virt <= end_virt_fim; end_virt++) {
-    if (mem_escreve(self->mem2, end_fis, prog_dado(programa, end_virt)) != ERR_OK) {
-      console_printf("Erro na carga da memória, end virt %d fís %d\n", end_virt, end_fis);
-      return -1;
+// retorna a imagem já carregada do programa, ou NULL
+static imagem_t *so_acha_imagem(so_t *self, char *nome_do_executavel)
+{
+  for (imagem_t *imagem = self->imagens; imagem != NULL; imagem = imagem->prox) {
+    if (strcmp(imagem->nome, nome_do_executavel) == 0) return imagem;
+  }
+  return NULL;
+}
+
+static bool so_libera_imagens_sem_uso(so_t *self)
+{
+  bool alguma = false;
+  imagem_t **pimagem = &self->imagens;
+  while (*pimagem != NULL) {
+    imagem_t *imagem = *pimagem;
+    if (imagem->n_refs > 0) {
+      pimagem = &imagem->prox;
+      continue;
     }
-    end_fis++;
+    *pimagem = imagem->prox;
+    for (int pagina = 0; pagina < imagem->n_paginas; pagina++) {
+      quadros_libera(self->quadros_mem2, imagem->blocos[pagina]);
+    }
+    console_log(LOG_DEPURA, "SO: imagem de '%s' descartada", imagem->nome);
+    free(imagem->nome);
+    free(imagem->blocos);
+    free(imagem);
+    alguma = true;
   }
+  return alguma;
+}
 
-  // atualiza o quadro livre inicial da memória secundária
-  self->quadro_livre_mem2 = quadro_fim + 1;
-  // guarda o quadro de mem2 no qual o programa do processo foi carregado
-  processo->quadro_mem2 = quadro_ini;
+// lê o programa do arquivo e cria a sua imagem na memória secundária
+// cada página é colocada em um bloco livre qualquer da memória secundária
+// retorna NULL em caso de erro
+static imagem_t *so_cria_imagem(so_t *self, char *nome_do_executavel)
+{
+  programa_t *programa = prog_cria(nome_do_executavel);
+  if (programa == NULL) {
+    console_log(LOG_ERRO, "Erro na leitura do programa '%s'\n", nome_do_executavel);
+    return NULL;
+  }
+
+  // calcula o número de páginas necessárias para o programa, que ocupa a
+  //   memória virtual a partir do endereço 0
+  int tamanho = prog_tamanho(programa);
+  int n_paginas = (tamanho + self->tam_pagina - 1) / self->tam_pagina;
+  if (n_paginas > quadros_n_livres(self->quadros_mem2)) {
+    so_libera_imagens_sem_uso(self);
+  }
+  if (n_paginas > quadros_n_livres(self->quadros_mem2)) {
+    console_log(LOG_ERRO, "SO: memória secundária insuficiente para %d páginas",
+                n_paginas);
+    prog_destroi(programa);
+    return NULL;
+  }
 
-  console_printf("SO: carga na memória secundária V%d-%d F%d-%d npag=%d",
-                 end_virt_ini, end_virt_fim, end_fis_ini, end_fis - 1, n_paginas);
-  return end_virt_ini;
+  imagem_t *imagem = malloc(sizeof(*imagem));
+  assert(imagem != NULL);
+  imagem->nome = malloc(strlen(nome_do_executavel) + 1);
+  assert(imagem->nome != NULL);
+  strcpy(imagem->nome, nome_do_executavel);
+  imagem->n_paginas = n_paginas;
+  imagem->blocos = malloc(n_paginas * sizeof(int));
+  assert(imagem->blocos != NULL);
+  imagem->n_refs = 0;
+
+  // carrega o programa na memória secundária (os blocos alocados estão
+  //   dentro dela, a escrita não tem como dar erro)
+  const int *dados = prog_dados(programa);
+  for (int pagina = 0; pagina < n_paginas; pagina++) {
+    int bloco = quadros_aloca(self->quadros_mem2, BLOCO_IMAGEM);
+    imagem->blocos[pagina] = bloco;
+    int end_virt = pagina * self->tam_pagina;
+    // a última página pode estar incompleta
+    int n = self->tam_pagina;
+    if (end_virt + n > tamanho) n = tamanho - end_virt;
+    mem_escreve_bloco(self->mem2, bloco * self->tam_pagina, n, &dados[end_virt]);
+  }
+  prog_destroi(programa);
+
+  imagem->prox = self->imagens;
+  self->imagens = imagem;
+  console_log(LOG_DEPURA, "SO: imagem de '%s' na memória secundária, npag=%d",
+              nome_do_executavel, n_paginas);
+  return imagem;
+}
+
+static simbolos_t *so_simbolos_do_programa(so_t *self, char *nome_do_executavel)
+{
+  simbolos_programa_t *sp;
+  for (sp = self->simbolos_programas; sp != NULL; sp = sp->prox) {
+    if (strcmp(sp->nome, nome_do_executavel) == 0) return sp->simbolos;
+  }
+  sp = malloc(sizeof(*sp));
+  assert(sp != NULL);
+  sp->nome = malloc(strlen(nome_do_executavel) + 1);
+  assert(sp->nome != NULL);
+  strcpy(sp->nome, nome_do_executavel);
+  sp->simbolos = simbolos_cria();
+  if (!simbolos_le(sp->simbolos, nome_do_executavel)) {
+    console_log(LOG_DEPURA, "SO: '%s' sem tabela de símbolos", nome_do_executavel);
+  }
+  sp->prox = self->simbolos_programas;
+  self->simbolos_programas = sp;
+  return sp->simbolos;
+}
+
+static int so_carrega_programa_na_memoria_virtual(so_t *self,
+                                                  processo_t *processo,
+                                                  char *nome_do_executavel)
+{
+  // o programa é mapeado na memória virtual do processo, com todas as páginas
+  //   da tabela de páginas do processo inválidas; as páginas são colocadas na
+  //   memória principal por demanda (ver so_trata_falta_de_pagina), a partir
+  //   da imagem do programa na memória secundária, compartilhada com os outros
+  //   processos que executam o mesmo programa
+  imagem_t *imagem = so_acha_imagem(self, nome_do_executavel);
+  if (imagem == NULL) imagem = so_cria_imagem(self, nome_do_executavel);
+  if (imagem == NULL) return -1;
+
+  imagem->n_refs++;
+  processo->imagem = imagem;
+  processo->n_paginas = imagem->n_paginas;
+  processo->quadros_mem2 = malloc(imagem->n_paginas * sizeof(int));
+  assert(processo->quadros_mem2 != NULL);
+  memcpy(processo->quadros_mem2, imagem->blocos, imagem->n_paginas * sizeof(int));
+
+  console_log(LOG_DEPURA, "SO: '%s' na memória virtual do processo %d, npag=%d",
+              nome_do_executavel, processo->pid, imagem->n_paginas);
+  return 0;
 }
 
 
@@ -1217,34 +2458,80 @@ static int so_carrega_programa_na_memoria_virtual(so_t *self,
 // ACESSO À MEMÓRIA DOS PROCESSOS {{{1
 // ---------------------------------------------------------------------
 
+// copia 'n' valores da memória do processo para o vetor valores, a partir do
+//   endereço virtual 'end_virt'
+// o endereço é traduzido com a tabela de páginas do processo (que não precisa
+//   ser o corrente) uma vez por página, e o trecho de cada página é copiado de
+//   uma vez, do quadro da página na memória principal ou, se ela não estiver
+//   lá, de onde estiver a cópia atualizada dela
+static err_t so_copia_do_processo(so_t *self, processo_t *proc, int end_virt,
+                                  int n, int valores[n])
+{
+  if (end_virt < 0) return ERR_END_INV;
+  while (n > 0) {
+    int pagina = end_virt / self->tam_pagina;
+    int desl = end_virt % self->tam_pagina;
+    int n_pagina = self->tam_pagina - desl;
+    if (n_pagina > n) n_pagina = n;
+    int quadro;
+    err_t err;
+    if (tabpag_traduz(proc->tabpag, pagina, &quadro) == ERR_OK) {
+      err = mem_le_bloco(self->mem, quadro * self->tam_pagina + desl, n_pagina, valores);
+    } else {
+      err = so_le_pagina_ausente(self, proc, end_virt, n_pagina, valores);
+    }
+    if (err != ERR_OK) return err;
+    end_virt += n_pagina;
+    valores += n_pagina;
+    n -= n_pagina;
+  }
+  return ERR_OK;
+}
+
+// copia valores da memória do processo para o vetor valores, a partir do
+//   endereço virtual 'end_virt', até copiar um 0
+// a cópia é feita um trecho de página por vez (ver so_copia_do_processo),
+//   até o trecho que contém o 0
+// retorna o número de valores antes do 0, ou -1 se erro (não tem 0 nos
+//   primeiros 'tam' valores, erro de acesso à memória)
+static int so_copia_ate_zero_do_processo(so_t *self, processo_t *proc,
+                                         int end_virt, int tam, int valores[tam])
+{
+  if (end_virt < 0) return -1;
+  int copiados = 0;
+  while (copiados < tam) {
+    int n = self->tam_pagina - (end_virt + copiados) % self->tam_pagina;
+    if (n > tam - copiados) n = tam - copiados;
+    if (so_copia_do_processo(self, proc, end_virt + copiados, n,
+                             &valores[copiados]) != ERR_OK) {
+      return -1;
+    }
+    for (int i = copiados; i < copiados + n; i++) {
+      if (valores[i] == 0) return i;
+    }
+    copiados += n;
+  }
+  return -1;
+}
+
 // copia uma string da memória do processo para o vetor str.
 // retorna false se erro (string maior que vetor, valor não char na memória,
 //   erro de acesso à memória)
 // O endereço é um endereço virtual de um processo.
-// t3: Com memória virtual, cada valor do espaço de endereçamento do processo
-//   pode estar em memória principal ou secundária (e tem que achar onde)
 static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
                                      int end_virt, processo_t processo)
 {
   if (processo.pid == SEM_PROCESSO) return false;
-  for (int indice_str = 0; indice_str < tam; indice_str++) {
-    int caractere;
-    // não tem memória virtual implementada, posso usar a mmu para traduzir
-    //   os endereços e acessar a memória, porque todo o conteúdo do processo
-    //   está na memória principal, e só temos uma tabela de páginas
-    if (mmu_le(self->mmu, end_virt + indice_str, &caractere, usuario) != ERR_OK) {
-      return false;
-    }
-    if (caractere < 0 || caractere > 255) {
+  int valores[tam];
+  int n = so_copia_ate_zero_do_processo(self, &processo, end_virt, tam, valores);
+  if (n == -1) return false;
+  for (int i = 0; i <= n; i++) {
+    if (valores[i] < 0 || valores[i] > 255) {
       return false;
     }
-    str[indice_str] = caractere;
-    if (caractere == 0) {
-      return true;
-    }
+    str[i] = valores[i];
   }
-  // estourou o tamanho de str
-  return false;
+  return true;
 }
 
 // vim: foldmethod=marker
@@ -15,11 +15,90 @@ typedef struct processo_t processo_t;
 #include "cpu.h"
 #include "es.h"
 #include "console.h" // só para uma gambiarra
+#include "perfil.h"
 
 so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_secundaria, mmu_t *mmu,
               es_t *es, console_t *console);
 void so_destroi(so_t *self);
 
+// escalonadores de processos
+typedef enum {
+  ESCAL_SIMPLES,      // o corrente executa até bloquear, depois o primeiro pronto
+  ESCAL_ROUND_ROBIN,  // os prontos executam na ordem em que ficaram prontos
+  ESCAL_PRIORIDADE,   // o pronto que usou menos o seu quantum ultimamente
+  ESCAL_MLFQ,         // filas de vários níveis, com quantum por nível e
+                      //   realimentação (desce quem gasta o quantum)
+  N_ESCAL
+} so_escalonador_t;
+
+// define o escalonador de processos (o padrão é ESCAL_SIMPLES)
+// deve ser chamada antes do início da execução
+void so_define_escalonador(so_t *self, so_escalonador_t alg);
+
+// define o intervalo entre interrupções do relógio, em instruções executadas,
+//   e o quantum, em interrupções do relógio, dos escalonadores ESCAL_ROUND_ROBIN
+//   e ESCAL_PRIORIDADE (nesses, o processo que gasta o quantum volta para o
+//   fim da fila de prontos); o padrão é SO_INTERVALO_RELOGIO e SO_QUANTUM
+// o intervalo deve ser pelo menos SO_INTERVALO_RELOGIO_MIN
+// deve ser chamada antes do início da execução
+void so_define_quantum(so_t *self, int intervalo, int quantum);
+
+// menor intervalo entre interrupções do relógio: o tratador de interrupção
+//   (trata_int.asm) ainda executa 4 instruções depois de o SO reprogramar o
+//   timer; com um intervalo menor, a interrupção seguinte já está pendente
+//   no RETI, e nenhuma instrução de usuário é executada
+#define SO_INTERVALO_RELOGIO_MIN 6
+
+// valores padrão do intervalo entre interrupções do relógio, do quantum e do
+//   tamanho inicial da tabela de processos
+#define SO_INTERVALO_RELOGIO 50  // em instruções executadas
+#define SO_QUANTUM 10            // em interrupções do relógio
+#define SO_N_PROCESSOS 5
+
+// reserva espaço na tabela de processos para 'n_processos' processos (o
+//   padrão é SO_N_PROCESSOS; a tabela aumenta quando fica cheia)
+// deve ser chamada antes do início da execução
+void so_define_n_processos(so_t *self, int n_processos);
+
+// define o programa executado pelo processo criado na inicialização do SO
+//   (o padrão é "init.maq")
+// deve ser chamada antes do início da execução
+void so_define_programa_inicial(so_t *self, char *nome);
+
+// retorna o número de processos criados, de trocas do processo em execução
+//   e de preempções (vezes em que um processo foi tirado de execução sem
+//   bloquear, mesmo que tenha sido escolhido de novo em seguida)
+void so_estatisticas_escalonamento(so_t *self, long *pprocessos,
+                                   long *ptrocas, long *ppreempcoes);
+
+// define o perfil de execução onde registrar o processo em execução (ver
+//   perfil.h), ou NULL para não registrar (o padrão)
+void so_define_perfil(so_t *self, perfil_t *perfil);
+
+// retorna o nome de um escalonador de processos
+char *so_nome_escalonador(so_escalonador_t alg);
+
+// algoritmos de substituição de páginas
+typedef enum {
+  SUBST_FIFO,            // a página carregada há mais tempo
+  SUBST_SEGUNDA_CHANCE,  // FIFO, mas poupa uma vez as páginas acessadas
+  SUBST_LRU,             // aproximação de LRU por envelhecimento
+  SUBST_NRU,             // não usada recentemente, pelos bits de acesso e alteração
+  N_SUBST
+} so_substituicao_t;
+
+// define o algoritmo de substituição de páginas (o padrão é SUBST_FIFO)
+// deve ser chamada antes do início da execução
+void so_define_substituicao(so_t *self, so_substituicao_t alg);
+
+// retorna o nome de um algoritmo de substituição de páginas
+char *so_nome_substituicao(so_substituicao_t alg);
+
+// retorna o número de faltas de página, de substituições de página e de
+//   escritas de páginas alteradas na memória secundária
+void so_estatisticas_paginacao(so_t *self, long *pfaltas,
+                               long *psubstituicoes, long *pescritas);
+
 // Chamadas de sistema
 // Uma chamada de sistema é realizada colocando a identificação da
 //   chamada (um dos valores abaixo) no registrador A e executando a
@@ -79,4 +158,19 @@ void so_destroi(so_t *self);
 // retorna sem bloquear, com erro, se não existir processo com esse pid
 #define SO_ESPERA_PROC 9
 
+// suspende o processo chamador por um tempo
+// recebe em X o número de instruções a dormir
+// retorna em A: 0 se OK ou um código de erro negativo
+// o processo volta a executar depois de passado o tempo pedido, mas não
+//   necessariamente logo depois
+#define SO_DORME      10
+
+// escreve uma string no dispositivo de saída do processo
+// recebe em X o endereço do primeiro caractere da string, que termina no
+//   primeiro valor 0 e deve ter no máximo 127 caracteres
+// retorna em A: 0 se OK ou um código de erro negativo
+// a string é escrita de uma vez, sem se misturar com o que outros processos
+//   escrevem no mesmo dispositivo
+#define SO_ESCR_STR   11
+
 #endif // SO_H
@@ -33,6 +33,10 @@ struct terminal_t {
   enum { normal, rolando, limpando } estado_saida;
   // posicao do caractere que está sendo movido durante uma rolagem
   int pos_rolagem;
+  // arquivo que recebe uma cópia da saída (NULL se não tiver)
+  FILE *arquivo_saida;
+  // interrupções habilitadas (TERM_INT_TECLADO, TERM_INT_TELA)
+  int interrupcoes;
 };
 
 
@@ -48,6 +52,8 @@ terminal_t *terminal_cria(int tam_linha)
   assert(self->saida != NULL && self->entrada != NULL);
 
   self->estado_saida = normal;
+  self->arquivo_saida = NULL;
+  self->interrupcoes = 0;
 
   return self;
 }
@@ -92,6 +98,10 @@ static err_t terminal_imprime(terminal_t *self, char ch)
 {
   if (!terminal_pode_imprimir(self)) return ERR_OCUP;
 
+  if (self->arquivo_saida != NULL) {
+    fputc(ch, self->arquivo_saida);
+  }
+
   if (ch == '\n') {
     // se for impresso \n, inicia a limpeza da linha
     self->estado_saida = limpando;
@@ -116,6 +126,11 @@ void terminal_limpa_saida(terminal_t *self)
   self->estado_saida = normal;
 }
 
+void terminal_define_arquivo_saida(terminal_t *self, FILE *arq)
+{
+  self->arquivo_saida = arq;
+}
+
 static void terminal_atualiza_rolagem(terminal_t *self)
 {
   if (self->estado_saida != rolando) return;
@@ -148,6 +163,47 @@ void terminal_tictac(terminal_t *self)
   terminal_atualiza_limpeza(self);
 }
 
+void terminal_avanca(terminal_t *self, int n)
+{
+  // depois de voltar ao estado normal, tictac não altera mais nada
+  while (n > 0 && self->estado_saida != normal) {
+    terminal_tictac(self);
+    n--;
+  }
+}
+
+int terminal_tempo_ate_imprimir(terminal_t *self)
+{
+  int tam;
+  switch (self->estado_saida) {
+    case rolando:
+      // rola até trazer o '\0' para a posição de rolagem
+      return strlen(self->saida + self->pos_rolagem + 1) + 1;
+    case limpando:
+      // remove um caractere por vez; uma linha vazia leva um tic
+      tam = strlen(self->saida);
+      return tam > 0 ? tam : 1;
+    default:
+      return 0;
+  }
+}
+
+bool terminal_interrupcao_teclado(terminal_t *self)
+{
+  return (self->interrupcoes & TERM_INT_TECLADO) && !terminal_entrada_vazia(self);
+}
+
+bool terminal_interrupcao_tela(terminal_t *self)
+{
+  return (self->interrupcoes & TERM_INT_TELA) && terminal_pode_imprimir(self);
+}
+
+bool terminal_vai_interromper(terminal_t *self)
+{
+  return (self->interrupcoes & TERM_INT_TELA) != 0
+         || terminal_interrupcao_teclado(self);
+}
+
 char *terminal_txt_entrada(terminal_t *self)
 {
   return self->entrada;
@@ -159,13 +215,12 @@ char *terminal_txt_saida(terminal_t *self)
 }
 
 // Operações de leitura e escrita no terminal, chamadas pelo controlador de E/S
-// Para o controlador, cada terminal é composto por 4 subdispositivos:
-//   leitura, estado da leitura, escrita, estado da escrita
+// Para o controlador, cada terminal é composto por 5 subdispositivos:
+//   leitura, estado da leitura, escrita, estado da escrita, interrupções
 err_t terminal_leitura(void *disp, int id, int *pvalor)
 {
   terminal_t *self = disp;
-  int subdisp = id % 4;
-  switch (subdisp) {
+  switch (id) {
     case TERM_TECLADO: // leitura do teclado
       return terminal_le_char(self, pvalor);
     case TERM_TECLADO_OK: // estado do teclado
@@ -176,6 +231,9 @@ err_t terminal_leitura(void *disp, int id, int *pvalor)
     case TERM_TELA_OK: // estado da tela
       *pvalor = terminal_pode_imprimir(self);
       break;
+    case TERM_INTERRUPCAO: // interrupções habilitadas
+      *pvalor = self->interrupcoes;
+      break;
     default:
       return ERR_DISP_INV;
   }
@@ -185,8 +243,12 @@ err_t terminal_leitura(void *disp, int id, int *pvalor)
 err_t terminal_escrita(void *disp, int id, int valor)
 {
   terminal_t *self = disp;
-  int subdisp = id % 4;
-  // só pode escrever na tela
-  if (subdisp != TERM_TELA) return ERR_OP_INV;
+  // só pode escrever na tela e nas interrupções habilitadas
+  if (id == TERM_INTERRUPCAO) {
+    if ((valor & ~(TERM_INT_TECLADO | TERM_INT_TELA)) != 0) return ERR_OP_INV;
+    self->interrupcoes = valor;
+    return ERR_OK;
+  }
+  if (id != TERM_TELA) return ERR_OP_INV;
   return terminal_imprime(self, valor);
 }
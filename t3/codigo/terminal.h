@@ -11,11 +11,15 @@
 // mantém o conteúdo da linha de saída de um terminal (o que aparece na tela) e
 // da linha de entrada (o que foi digitado e ainda não foi lido pela CPU)
 //
-// implementa 4 dispositivos associados a um terminal:
+// implementa 5 dispositivos associados a um terminal:
 // - leitura do próximo caractere de entrada
 // - leitura do estado da entrada (se tem caractere disponível ou não)
 // - escrita de um caractere na saída
 // - leitura do estado da saída (se um caractere pode ser escrito ou não)
+// - leitura ou escrita das interrupções habilitadas (TERM_INT_TECLADO e/ou
+//   TERM_INT_TELA); com a do teclado habilitada, o terminal pede interrupção
+//   enquanto tiver caractere na entrada, com a da tela, enquanto um caractere
+//   puder ser escrito. no início, as duas estão desabilitadas
 //
 // a leitura não é possível quando não existir caractere na entrada
 // existe um limite para caracteres digitados e não lidos; caracteres adicionais
@@ -34,15 +38,21 @@
 //   linha de saída com terminal_limpa_saida.
 
 #include <stdbool.h>
+#include <stdio.h>
 #include "err.h"
 
 typedef struct terminal_t terminal_t;
 
-// os 4 dispositivos associados a um terminal
+// os 5 dispositivos associados a um terminal
 #define TERM_TECLADO    0
 #define TERM_TECLADO_OK 1
 #define TERM_TELA       2
 #define TERM_TELA_OK    3
+#define TERM_INTERRUPCAO 4
+
+// as interrupções que podem ser habilitadas em TERM_INTERRUPCAO
+#define TERM_INT_TECLADO 1
+#define TERM_INT_TELA    2
 
 // aloca e inicializa um novo terminal
 terminal_t *terminal_cria(int tam_linha);
@@ -62,9 +72,28 @@ void terminal_insere_char(terminal_t *self, char ch);
 // limpa a linha de saída (para uso pela console)
 void terminal_limpa_saida(terminal_t *self);
 
+// define um arquivo onde é copiado cada caractere impresso no terminal
+// (para uso pela console, quando executa sem tela); NULL para não copiar
+void terminal_define_arquivo_saida(terminal_t *self, FILE *arq);
+
 // esta função deve ser chamada periodicamente
 void terminal_tictac(terminal_t *self);
 
+// tem o mesmo efeito de 'n' chamadas a terminal_tictac
+void terminal_avanca(terminal_t *self, int n);
+
+// retorna quantas chamadas a terminal_tictac faltam para o terminal poder
+//   imprimir outro caractere (0 se já pode)
+int terminal_tempo_ate_imprimir(terminal_t *self);
+
+// retorna true se o terminal está pedindo a interrupção do teclado ou da tela
+bool terminal_interrupcao_teclado(terminal_t *self);
+bool terminal_interrupcao_tela(terminal_t *self);
+
+// retorna true se o terminal vai pedir interrupção mesmo sem nada ser
+//   digitado: a interrupção da tela está habilitada (a tela fica livre sozinha)
+bool terminal_vai_interromper(terminal_t *self);
+
 // Funções para implementar o protocolo de acesso a um dispositivo pelo
 //   controlador de E/S
 // Devem seguir o protocolo f_leitura_t e f_escrita_t declarados em es.h
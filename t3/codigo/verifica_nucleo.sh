@@ -0,0 +1,70 @@
+#!/bin/bash
+# compara a execução rápida do simulador sem tela com a execução de
+#   referência, para todas as combinações de configuração e programa inicial
+# a rápida usa o núcleo de CPU com "threaded code" e executa em lotes de
+#   tics (ver cpu_executa em cpu.h e controle_executa_lote em controle.c); a
+#   de referência usa o núcleo que executa uma instrução por vez, com um tic
+#   por lote, como na execução com tela
+# as duas versões são compiladas em diretórios temporários, e para cada
+#   execução são comparados o rastro da CPU (main -r, o estado antes de cada
+#   instrução), as saídas dos terminais, o log da console e as estatísticas
+#   (main -m)
+# deve ser executado no diretório do simulador (ver o alvo verifica no
+#   Makefile); os programas podem ser trocados por variável de ambiente, por
+#   exemplo: PROGRAMAS="init p1" ./verifica_nucleo.sh
+
+PROGRAMAS=${PROGRAMAS:-"init p1 p2 p3 ex3 carga_cpu carga_es carga_mem"}
+TEMPO_MAX=${TEMPO_MAX:-120}  # em segundos, para cada execução
+# cada configuração é uma lista de linhas 'nome valor' do arquivo de
+#   configuração (ver main -c), separadas por ';'
+CONFIGURACOES=(
+  ""
+  "escalonador mlfq;quantum 2"
+  "escalonador round_robin;intervalo_relogio 7;tempo_disco 1"
+  "mem_tam 160;substituicao lru"
+  "escalonador prioridade;mem_tam 240;tam_pagina 20;substituicao segunda_chance"
+)
+ARQUIVOS="rastro metricas saida_term_a saida_term_b saida_term_c saida_term_d
+          log_da_console"
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# compila uma versão do simulador no diretório $1, com as opções $2
+compila() {
+  mkdir "$1"
+  cp *.c *.h *.asm Makefile "$1"
+  make -s -C "$1" CPPFLAGS="$2" > /dev/null 2> "$1/make.err" || {
+    cat "$1/make.err" >&2
+    exit 1
+  }
+}
+compila "$tmp/ref" "-DCPU_NUCLEO_REFERENCIA -DCONTROLE_LOTE_MAX=1"
+compila "$tmp/rap" ""
+
+falhas=0
+for cfg in "${CONFIGURACOES[@]}"; do
+for prog in $PROGRAMAS; do
+  echo "$cfg;programa_inicial $prog.maq" | tr ';' '\n' > "$tmp/cfg"
+  for versao in ref rap; do
+    (cd "$tmp/$versao" \
+     && rm -f rastro metricas \
+     && timeout "$TEMPO_MAX" ./main -s -c ../cfg -m metricas -r rastro > /dev/null)
+    echo $? > "$tmp/$versao/rc"
+  done
+  difs=""
+  for arq in rc $ARQUIVOS; do
+    cmp -s "$tmp/ref/$arq" "$tmp/rap/$arq" || difs="$difs $arq"
+  done
+  if [ -z "$difs" ]; then
+    echo "ok: ${cfg:-padrão}, $prog ($(wc -l < "$tmp/ref/rastro") instruções)"
+  else
+    echo "DIFERENTE: ${cfg:-padrão}, $prog:$difs"
+    cmp "$tmp/ref/rastro" "$tmp/rap/rastro"
+    falhas=$((falhas + 1))
+  fi
+done
+done
+
+echo "$falhas execuções diferentes"
+[ $falhas = 0 ]